@@ -13,6 +13,7 @@ struct sleeplock;
 struct stat;
 struct superblock;
 struct pstat;
+struct schedevent;
 
 
 // bio.c
@@ -83,6 +84,7 @@ int             lapicid(void);
 extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
+void            lapicsettimer(int);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
@@ -127,6 +129,10 @@ void            wakeup(void*);
 void            yield(void);
 int             settickets(int);
 int             getpinfo(struct pstat*);
+int             gettrace(struct schedevent*, int);
+int             setaffinity(int, uint);
+int             getaffinity(int);
+int             setgroup(int);
 
 // swtch.S
 void            swtch(struct context**, struct context*);
@@ -169,6 +175,7 @@ void            timerinit(void);
 // trap.c
 void            idtinit(void);
 extern uint     ticks;
+extern uint     tickcycles;
 void            tvinit(void);
 extern struct spinlock tickslock;
 
@@ -7,10 +7,18 @@
 #include "proc.h"
 #include "spinlock.h"
 #include "pstat.h"  
+#include "schedtrace.h"
+
+// Sleeping processes are kept in queues hashed by the channel
+// they sleep on, so wakeup() only visits processes in one queue.
+#define SLEEPQSHIFT 6
+#define NSLEEPQ (1 << SLEEPQSHIFT)
 
 struct {
   struct spinlock lock;
   struct proc proc[NPROC];
+  struct proc *sleepq[NSLEEPQ];
+  struct group group[NGROUP];
 } ptable;
 
 static struct proc *initproc;
@@ -19,16 +27,54 @@ int nextpid = 1;
 extern void forkret(void);
 extern void trapret(void);
 
-int global_tickets = 0;     // Sum of tickets of all runnable processes
-int global_stride = 0;      // STRIDE1/global_tickets
-int global_pass = 0;        // Global pass value
+uint mlfq_seq = 0;          // Next FIFO position within an MLFQ level
+uint mlfq_lastboost = 0;    // Tick of the last MLFQ priority boost
+
+// Per-CPU ring of scheduling events. Only the owning CPU advances
+// head, with interrupts off, so recording an event takes no lock.
+// Readers are serialized by tracelock and only advance tail.
+struct {
+  struct schedevent ev[NSCHEDEV];
+  volatile uint head;          // Next slot the owning CPU fills
+  volatile uint tail;          // Next slot to hand to user space
+  volatile uint dropped;       // Events lost because the ring was full
+  uint reported;               // Drops already reported to user space
+} schedring[NCPU];
+
+struct spinlock tracelock;
 
 static void wakeup1(void *chan);
+static void wakeproc(struct proc *p);
 
 void
 pinit(void)
 {
   initlock(&ptable.lock, "ptable");
+  initlock(&tracelock, "trace");
+}
+
+// Record a scheduling event about p in this CPU's ring.
+// Must be called with interrupts disabled.
+static void
+traceevent(int type, struct proc *p, int arg)
+{
+  int id = cpuid();
+  uint h = schedring[id].head;
+  struct schedevent *e;
+
+  if(h - schedring[id].tail >= NSCHEDEV){
+    schedring[id].dropped++;
+    return;
+  }
+  e = &schedring[id].ev[h % NSCHEDEV];
+  e->tsc = rdtsc();
+  e->type = type;
+  e->cpu = id;
+  e->pid = p->pid;
+  e->tickets = p->tickets;
+  e->arg = arg;
+  __sync_synchronize();  // publish the event before the new head
+  schedring[id].head = h + 1;
 }
 
 // Must be called with interrupts disabled
@@ -70,6 +116,201 @@ myproc(void) {
   return p;
 }
 
+// Whether p's affinity mask lets it run on c.
+static int
+canrun(struct proc *p, struct cpu *c)
+{
+  return (p->affinity >> (c - cpus)) & 1;
+}
+
+// Each CPU keeps its own run queue for the stride scheduler: the
+// RUNNABLE processes whose p->cpu is that CPU, with their own
+// weight total, stride and virtual time (pass). A process's pass is
+// only meaningful against the pass of the CPU it is queued on.
+//
+// A process's weight is its effective tickets in 1/WEIGHT1 units.
+// Outside a group that is just its tickets. Inside one, the group's
+// tickets are split among its runnable members in proportion to
+// their own tickets, so a job gets the same aggregate share however
+// many processes it forks.
+
+// Effective tickets of queued process p, in 1/WEIGHT1 units.
+static int
+weightof(struct proc *p)
+{
+  struct group *g;
+  int w;
+
+  if(p->group < 0)
+    return p->tickets * WEIGHT1;
+  g = &ptable.group[p->group];
+  w = g->tickets * p->tickets * WEIGHT1 / g->runnable;
+  return w > 0 ? w : 1;
+}
+
+// Make p a member of group g, or of none if g is -1.
+// p must not be queued. The ptable lock must be held.
+static void
+joingroup(struct proc *p, int g)
+{
+  p->group = g;
+  if(g >= 0)
+    ptable.group[g].members++;
+}
+
+// Take p out of its group, freeing the group if p was the last
+// member. p must not be queued. The ptable lock must be held.
+static void
+leavegroup(struct proc *p)
+{
+  if(p->group >= 0)
+    ptable.group[p->group].members--;
+  p->group = -1;
+}
+
+// Add delta to c's runnable weight and recompute its stride.
+// The ptable lock must be held.
+static void
+addweight(struct cpu *c, int delta)
+{
+  c->weight += delta;
+  if(c->weight > 0)  // Prevent division by zero
+    c->stride = STRIDE1 * WEIGHT1 / c->weight;
+  else
+    c->stride = 0;
+}
+
+// Recompute the weight and stride of every queued member of
+// group g after its runnable tickets changed.
+// The ptable lock must be held.
+static void
+regroup(int g)
+{
+  struct proc *p;
+  int w;
+
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->group != g || p->weight == 0)
+      continue;
+    w = weightof(p);
+    addweight(&cpus[p->cpu], w - p->weight);
+    p->weight = w;
+    p->stride = STRIDE1 * WEIGHT1 / w;
+  }
+}
+
+// Add p to the run queue of cpus[p->cpu], charging its weight there.
+// The ptable lock must be held.
+static void
+enqueue(struct proc *p)
+{
+  if(p->group >= 0){
+    ptable.group[p->group].runnable += p->tickets;
+    regroup(p->group);
+  }
+  p->weight = weightof(p);
+  p->stride = STRIDE1 * WEIGHT1 / p->weight;
+  addweight(&cpus[p->cpu], p->weight);
+}
+
+// Take p off its run queue.
+// The ptable lock must be held.
+static void
+dequeue(struct proc *p)
+{
+  addweight(&cpus[p->cpu], -p->weight);
+  p->weight = 0;
+  if(p->group >= 0){
+    ptable.group[p->group].runnable -= p->tickets;
+    regroup(p->group);
+  }
+}
+
+#ifdef STRIDE
+// The started CPU that p may run on with the least runnable weight.
+// The ptable lock must be held.
+static struct cpu*
+leastloaded(struct proc *p)
+{
+  struct cpu *c, *best = 0;
+
+  for(c = cpus; c < &cpus[ncpu]; c++){
+    if(!c->started || !canrun(p, c))
+      continue;
+    if(best == 0 || c->weight < best->weight)
+      best = c;
+  }
+  if(best == 0)  // Only the boot CPU, before it finished starting
+    best = &cpus[0];
+  return best;
+}
+
+// Queue a process that is becoming RUNNABLE for the first time on
+// the least loaded CPU it may run on.
+// The ptable lock must be held.
+static void
+place(struct proc *p)
+{
+  struct cpu *best = leastloaded(p);
+
+  p->cpu = best - cpus;
+  p->pass = best->pass;
+  p->remain = 0;
+  enqueue(p);
+}
+
+// Move RUNNABLE p to c's run queue. Its lead or lag relative to
+// the old CPU's virtual time carries over to the new one, so a
+// migration neither rewards nor penalizes it.
+// The ptable lock must be held.
+static void
+migrate(struct proc *p, struct cpu *c)
+{
+  struct cpu *from = &cpus[p->cpu];
+
+  p->remain = p->pass - from->pass;
+  addweight(from, -p->weight);
+  p->cpu = c - cpus;
+  p->pass = c->pass + p->remain;
+  addweight(c, p->weight);
+}
+
+// Ticket-weighted load balancing. If the CPU with the most runnable
+// weight has a waiting process whose move to c would narrow the
+// gap between the two, pull the heaviest such process over.
+// The ptable lock must be held.
+static void
+balance(struct cpu *c)
+{
+  struct cpu *b, *busiest = 0;
+  struct proc *p, *pick = 0;
+  int gap;
+
+  for(b = cpus; b < &cpus[ncpu]; b++){
+    if(b == c || !b->started)
+      continue;
+    if(busiest == 0 || b->weight > busiest->weight)
+      busiest = b;
+  }
+  if(busiest == 0 || (gap = busiest->weight - c->weight) <= 0)
+    return;
+
+  // Moving weight w narrows the gap only if w < gap, which also
+  // keeps two CPUs from passing a process back and forth.
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->state != RUNNABLE || p->cpu != busiest - cpus ||
+       p->weight >= gap || !canrun(p, c))
+      continue;
+    if(pick == 0 || p->weight > pick->weight ||
+       (p->weight == pick->weight &&
+        p->pass - busiest->pass < pick->pass - busiest->pass))
+      pick = p;
+  }
+  if(pick)
+    migrate(pick, c);
+}
+#endif
+
 //PAGEBREAK: 32
 // Look in the process table for an UNUSED proc.
 // If found, change state to EMBRYO and initialize
@@ -97,9 +338,22 @@ found:
   // Initialize stride scheduler fields
   p->tickets = DEFAULT_TICKETS;  // Default value is 8
   p->stride = STRIDE1 / p->tickets;
-  p->pass = global_pass;
+  p->pass = 0;                   // Set when it is placed on a CPU
   p->remain = 0;
+  p->cpu = 0;
+  p->weight = 0;
+  p->group = -1;
+  p->affinity = ALLCPUS;
+  p->lastcpu = -1;
+  p->migrations = 0;
   p->rtime = 0;
+  p->cycles = 0;
+  p->switches = 0;
+
+  // New processes start at the highest MLFQ level
+  p->level = 0;
+  p->qticks = 0;
+  p->qseq = mlfq_seq++;
 
   release(&ptable.lock);
 
@@ -161,10 +415,11 @@ userinit(void)
   acquire(&ptable.lock);
 
   p->state = RUNNABLE;
-  
-  // Update global tickets and global stride
-  global_tickets += p->tickets;
-  global_stride = STRIDE1 / global_tickets;
+  traceevent(SCHED_WAKEUP, p, 0);
+
+  #ifdef STRIDE
+  place(p);
+  #endif
 
   release(&ptable.lock);
 }
@@ -225,15 +480,18 @@ fork(void)
   np->cwd = idup(curproc->cwd);
 
   safestrcpy(np->name, curproc->name, sizeof(curproc->name));
+  np->affinity = curproc->affinity;
 
   pid = np->pid;
 
   acquire(&ptable.lock);
+  joingroup(np, curproc->group);  // Children share the parent's group
   np->state = RUNNABLE;
-  
-  // Update global tickets and global stride
-  global_tickets += np->tickets;
-  global_stride = STRIDE1 / global_tickets;
+  traceevent(SCHED_WAKEUP, np, 0);
+
+  #ifdef STRIDE
+  place(np);
+  #endif
 
   release(&ptable.lock);
   return pid;
@@ -279,14 +537,11 @@ exit(void)
     }
   }
 
-  // Update global tickets and global stride if the process is RUNNABLE or RUNNING
-  if(curproc->state == RUNNABLE || curproc->state == RUNNING) {
-    global_tickets -= curproc->tickets;
-    if(global_tickets > 0)
-      global_stride = STRIDE1 / global_tickets;
-    else
-      global_stride = 0;  // Handle division by zero
-  }
+  #ifdef STRIDE
+  // Leave the run queue of the CPU it is running on
+  dequeue(curproc);
+  #endif
+  leavegroup(curproc);
 
   // Jump into the scheduler, never to return.
   curproc->state = ZOMBIE;
@@ -338,6 +593,103 @@ wait(void)
   }
 }
 
+// Length of p's next quantum in ticks.
+static int
+timeslice(struct proc *p)
+{
+  #ifdef STRIDE
+  // Extra tickets buy a longer quantum rather than more frequent
+  // picks, which saves context switches for heavily weighted
+  // processes. pass is charged for the whole quantum.
+  int n = p->weight / (DEFAULT_TICKETS * WEIGHT1);
+  if(n < 1)
+    n = 1;
+  if(n > MAXSLICE)
+    n = MAXSLICE;
+  return n;
+  #elif defined(MLFQ)
+  // Whatever is left of the allotment at the current level
+  return (MLFQ_QUANTUM << p->level) - p->qticks;
+  #else
+  return 1;
+  #endif
+}
+
+// Let the next process run for n ticks before it is preempted.
+// The boot CPU keeps its periodic timer because it drives ticks,
+// so the slice is counted down in trap(). Other CPUs restart
+// their timer for the full slice and take one interrupt per slice.
+static void
+setslice(struct cpu *c, int n)
+{
+  c->slice = n;
+  if(c != &cpus[0]){
+    lapicsettimer(n);
+    c->tickspan = n;
+  }
+}
+
+// Switch to p for a quantum of slice ticks. Returns the number of
+// cycles it ran before control came back to the scheduler.
+static uint64
+runproc(struct cpu *c, struct proc *p, int slice)
+{
+  uint64 start, used;
+
+  c->proc = p;
+  switchuvm(p);
+  p->state = RUNNING;
+  p->switches++;
+  if(p->lastcpu >= 0 && p->lastcpu != c - cpus)
+    p->migrations++;
+  p->lastcpu = c - cpus;
+
+  setslice(c, slice);
+  traceevent(SCHED_SWITCHIN, p, 0);
+  start = rdtsc();
+  swtch(&(c->scheduler), p->context);
+  used = rdtsc() - start;
+  switchkvm();
+  p->cycles += used;
+  traceevent(SCHED_SWITCHOUT, p,
+             p->state == RUNNABLE ? SCHED_OUT_RUNNABLE :
+             p->state == SLEEPING ? SCHED_OUT_SLEEPING : SCHED_OUT_EXITED);
+
+  c->proc = 0;
+  return used;
+}
+
+#ifdef STRIDE
+// p was charged a full quantum of slice ticks up front but blocked
+// or exited after running only used cycles. Hand back the unused
+// part of its pass and of c's pass, so a process that gives up the
+// CPU early is only charged for what it consumed.
+static void
+refund(struct cpu *c, struct proc *p, int slice, int gstride, uint64 used)
+{
+  uint unit, ran, left, pref, gref;
+
+  if(tickcycles < 256)  // Not calibrated yet
+    return;
+  unit = tickcycles >> 8;  // Cycles per 1/256th of a tick
+  if(used >= (uint64)slice * tickcycles)
+    return;
+  ran = (uint)used / unit;
+  if(ran >= (slice << 8))
+    return;
+  left = (slice << 8) - ran;
+
+  pref = (p->stride * left) >> 8;
+  gref = (gstride * left) >> 8;
+  p->pass -= pref;
+  c->pass -= gref;
+
+  // sleep() already measured remain against the charged values
+  if(p->state == SLEEPING)
+    p->remain -= pref - gref;
+}
+#endif
+
 //PAGEBREAK: 42
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
@@ -351,19 +703,27 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  int idle, slice;
+  #ifdef STRIDE
+  int gstride;
+  uint64 used;
+  #endif
   c->proc = 0;
+  c->tickspan = 1;
   
   for(;;){
     // Enable interrupts on this processor.
     sti();
 
     acquire(&ptable.lock);
+    idle = 1;
 
     #ifdef STRIDE
     struct proc *min_proc = 0;
-    
+
+    balance(c);
     for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->state != RUNNABLE)
+      if(p->state != RUNNABLE || p->cpu != c - cpus)
         continue;
 
       // Selection criteria in order: pass value, runtime, pid
@@ -377,40 +737,120 @@ scheduler(void)
 
     if(min_proc != 0) {
       p = min_proc;
-      c->proc = p;
-      switchuvm(p);
-      p->state = RUNNING;
+      slice = timeslice(p);
+      gstride = c->stride;
       
       // Update scheduling metrics before running
-      global_pass += global_stride;  // Update global first
-      p->pass += p->stride;         // Then update process pass
-      p->rtime++;                   // Track runtime
+      c->pass += gstride * slice;           // Update this CPU first
+      p->pass += p->stride * slice;         // Then update process pass
+      p->rtime += slice;                    // Track runtime
 
-      swtch(&(c->scheduler), p->context);
-      switchkvm();
+      used = runproc(c, p, slice);
 
-      c->proc = 0;
+      // Only a process that comes back RUNNABLE was preempted by
+      // the timer after using its whole quantum.
+      if(p->state != RUNNABLE)
+        refund(c, p, slice, gstride, used);
+
+      // Affinity changed while it ran. A process that went to sleep
+      // must also wake up on a CPU it may use.
+      if(!canrun(p, c)){
+        if(p->state == RUNNABLE)
+          migrate(p, leastloaded(p));
+        else
+          p->cpu = leastloaded(p) - cpus;  // remain is relative
+      }
+
+      idle = 0;
+    }
+
+    #elif defined(MLFQ)
+    struct proc *min_proc = 0;
+
+    // Priority boost: periodically move every process back to the
+    // top level so CPU-bound processes are not starved.
+    // ticks is only read here, so tickslock is not needed.
+    if(ticks - mlfq_lastboost >= MLFQ_BOOST){
+      mlfq_lastboost = ticks;
+      for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+        if(p->state == UNUSED)
+          continue;
+        p->level = 0;
+        p->qticks = 0;
+      }
+    }
+
+    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+      if(p->state != RUNNABLE || !canrun(p, c))
+        continue;
+
+      // Selection criteria in order: level, position in the level
+      if(min_proc == 0 ||
+         p->level < min_proc->level ||
+         (p->level == min_proc->level && p->qseq < min_proc->qseq)) {
+        min_proc = p;
+      }
+    }
+
+    // Soft affinity: rather than the head of the level, take a
+    // process that last ran here if it is within ncpu places of the
+    // head. The other CPUs pick up the ones skipped, so FIFO order
+    // within the level is only loosened by that much.
+    if(min_proc != 0 && min_proc->lastcpu != c - cpus) {
+      for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+        if(p->state == RUNNABLE && p->lastcpu == c - cpus &&
+           canrun(p, c) && p->level == min_proc->level &&
+           p->qseq - min_proc->qseq < ncpu) {
+          min_proc = p;
+          break;
+        }
+      }
+    }
+
+    if(min_proc != 0) {
+      p = min_proc;
+      slice = timeslice(p);
+      p->rtime += slice;            // Track runtime
+
+      runproc(c, p, slice);
+
+      // A process that comes back RUNNABLE was preempted by the
+      // timer and used its whole slice. One that went to sleep
+      // keeps the rest of its allotment at this level.
+      if(p->state == RUNNABLE &&
+         (p->qticks += slice) >= (MLFQ_QUANTUM << p->level)) {
+        if(p->level < MLFQ_LEVELS - 1)
+          p->level++;
+        p->qticks = 0;
+        p->qseq = mlfq_seq++;       // Go to the back of the level
+      }
+
+      idle = 0;
     }
 
     #else
     // Round-Robin Scheduler
     for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->state != RUNNABLE)
+      if(p->state != RUNNABLE || !canrun(p, c))
         continue;
 
-      c->proc = p;
-      switchuvm(p);
-      p->state = RUNNING;
-      p->rtime++;  // Track runtime in RR mode too
+      slice = timeslice(p);
+      p->rtime += slice;  // Track runtime in RR mode too
       
-      swtch(&(c->scheduler), p->context);
-      switchkvm();
-
-      c->proc = 0;
+      runproc(c, p, slice);
+      idle = 0;
     }
     #endif
 
     release(&ptable.lock);
+
+    // Nothing was runnable: halt until the next interrupt rather
+    // than spinning on the process table. Interrupts are enabled
+    // again by the release above.
+    if(idle){
+      setslice(c, 1);
+      hlt();
+    }
   }
 }
 
@@ -471,6 +911,31 @@ forkret(void)
   // Return to "caller", actually trapret (see allocproc).
 }
 
+// Sleep queue that processes sleeping on chan are kept in.
+// Fibonacci hashing spreads out the aligned kernel addresses
+// used as channels.
+static struct proc**
+sleepq(void *chan)
+{
+  return &ptable.sleepq[((uint)chan * 2654435761U) >> (32 - SLEEPQSHIFT)];
+}
+
+// Take sleeping process p off its sleep queue.
+// The ptable lock must be held.
+static void
+sleepqremove(struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = sleepq(p->chan); *pp != 0; pp = &(*pp)->qnext){
+    if(*pp == p){
+      *pp = p->qnext;
+      break;
+    }
+  }
+  p->qnext = 0;
+}
+
 // Atomically release lock and sleep on chan.
 // Reacquires lock when awakened.
 void
@@ -496,17 +961,18 @@ sleep(void *chan, struct spinlock *lk)
   }
   #ifdef STRIDE
   // Calculate remain before going to sleep
-  p->remain = p->pass - global_pass;
+  p->remain = p->pass - cpus[p->cpu].pass;
   
-  // Update global tickets since process won't be running
-  global_tickets -= p->tickets;
-  if(global_tickets > 0)  // Prevent division by zero
-    global_stride = STRIDE1 / global_tickets;
+  // Leave the run queue since process won't be running
+  dequeue(p);
   #endif
 
   // Go to sleep.
   p->chan = chan;
   p->state = SLEEPING;
+  p->qnext = *sleepq(chan);
+  *sleepq(chan) = p;
+  traceevent(SCHED_SLEEP, p, 0);
 
   sched();
 
@@ -526,22 +992,39 @@ sleep(void *chan, struct spinlock *lk)
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
+  struct proc *p, **pp;
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan) {
-     #ifdef STRIDE
-      // Update pass value based on remain
-      p->pass = global_pass + p->remain;
-      #endif
-      p->state = RUNNABLE;
-      
-      #ifdef STRIDE
-      // Update global tickets since process is runnable again
-      global_tickets += p->tickets;
-      global_stride = STRIDE1 / global_tickets;
-      #endif
+  pp = sleepq(chan);
+  while((p = *pp) != 0){
+    if(p->chan != chan){
+      pp = &p->qnext;
+      continue;
     }
+    *pp = p->qnext;
+    p->qnext = 0;
+    wakeproc(p);
+  }
+}
+
+// Make sleeping process p RUNNABLE again. The caller has taken it
+// off its sleep queue. The ptable lock must be held.
+static void
+wakeproc(struct proc *p)
+{
+  #ifdef STRIDE
+  // Rejoin the run queue it slept on; balance() moves it if
+  // another CPU is less loaded.
+  p->pass = cpus[p->cpu].pass + p->remain;
+  enqueue(p);
+  #endif
+
+  p->state = RUNNABLE;
+  traceevent(SCHED_WAKEUP, p, 0);
+
+  #ifdef MLFQ
+  // Rejoin the back of the level it slept at
+  p->qseq = mlfq_seq++;
+  #endif
 }
 
 // Wake up all processes sleeping on chan.
@@ -567,12 +1050,8 @@ kill(int pid)
       p->killed = 1;
       // Wake process from sleep if necessary.
       if(p->state == SLEEPING) {
-        // Update pass value based on remain
-        p->pass = global_pass + p->remain;
-        p->state = RUNNABLE;
-        // Update global tickets since process is runnable again
-        global_tickets += p->tickets;
-        global_stride = STRIDE1 / global_tickets;
+        sleepqremove(p);
+        wakeproc(p);
       }
       release(&ptable.lock);
       return 0;
@@ -623,7 +1102,7 @@ int
 settickets(int number) 
 {
   struct proc *curproc = myproc();
-  int old_tickets, old_stride;
+  int old_stride, queued;
   
   // Validate ticket number
   if(number < 1) {
@@ -634,24 +1113,23 @@ settickets(int number)
 
   acquire(&ptable.lock);
   
-  old_tickets = curproc->tickets;
   old_stride = curproc->stride;
   
-  // Update process tickets and recalculate stride
+  // Update process tickets and recalculate stride. A queued process
+  // requeues so its CPU and group see the new tickets.
+  queued = curproc->weight > 0;
+  if(queued)
+    dequeue(curproc);
   curproc->tickets = number;
   curproc->stride = STRIDE1 / number;
+  if(queued)
+    enqueue(curproc);
   
   // Adjust remain based on new stride
   curproc->remain = curproc->remain * curproc->stride / old_stride;
   
   // Recalculate pass value
-  curproc->pass = global_pass + curproc->remain;
-  
-  // Update global tickets if process is RUNNABLE or RUNNING
-  if(curproc->state == RUNNABLE || curproc->state == RUNNING) {
-    global_tickets = global_tickets - old_tickets + number;
-    global_stride = STRIDE1 / global_tickets;
-  }
+  curproc->pass = cpus[curproc->cpu].pass + curproc->remain;
   
   release(&ptable.lock);
   return 0;
@@ -678,6 +1156,11 @@ getpinfo(struct pstat* ps)
     kps.remain[i] = p->remain;
     kps.stride[i] = p->stride;
     kps.rtime[i] = p->rtime;
+    kps.level[i] = p->level;
+    kps.cycles[i] = p->cycles;
+    kps.switches[i] = p->switches;
+    kps.migrations[i] = p->migrations;
+    kps.group[i] = p->group;
   }
   
   release(&ptable.lock);
@@ -688,3 +1171,166 @@ getpinfo(struct pstat* ps)
     
   return 0;
 }
+
+// Copy up to n buffered scheduling events to the user array uev,
+// merging the per-CPU rings oldest first. Overflowed rings are
+// reported with a SCHED_LOST event ahead of the rest.
+// Returns the number of events copied, or -1.
+int
+gettrace(struct schedevent *uev, int n)
+{
+  struct schedevent ev, *e;
+  int i, best, got;
+
+  got = 0;
+  acquire(&tracelock);
+
+  for(i = 0; i < ncpu && got < n; i++){
+    if(schedring[i].dropped == schedring[i].reported)
+      continue;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = SCHED_LOST;
+    ev.cpu = i;
+    ev.arg = schedring[i].dropped - schedring[i].reported;
+    schedring[i].reported += ev.arg;
+    if(copyout(myproc()->pgdir, (uint)(uev + got), &ev, sizeof(ev)) < 0)
+      goto bad;
+    got++;
+  }
+
+  while(got < n){
+    best = -1;
+    e = 0;
+    for(i = 0; i < ncpu; i++){
+      if(schedring[i].tail == schedring[i].head)
+        continue;
+      __sync_synchronize();  // read head before the slot it covers
+      if(e == 0 || schedring[i].ev[schedring[i].tail % NSCHEDEV].tsc < e->tsc){
+        e = &schedring[i].ev[schedring[i].tail % NSCHEDEV];
+        best = i;
+      }
+    }
+    if(best < 0)
+      break;
+    ev = *e;
+    __sync_synchronize();  // finish reading the slot before freeing it
+    schedring[best].tail++;
+    if(copyout(myproc()->pgdir, (uint)(uev + got), &ev, sizeof(ev)) < 0)
+      goto bad;
+    got++;
+  }
+
+  release(&tracelock);
+  return got;
+
+bad:
+  release(&tracelock);
+  return -1;
+}
+
+// Restrict the process with the given pid (0 for the caller) to the
+// CPUs whose bits are set in mask. Returns -1 if there is no such
+// process or mask allows none of the running CPUs.
+int
+setaffinity(int pid, uint mask)
+{
+  struct proc *p, *curproc = myproc();
+  struct cpu *c;
+  int ok = 0, move;
+
+  for(c = cpus; c < &cpus[ncpu]; c++)
+    if(c->started && ((mask >> (c - cpus)) & 1))
+      ok = 1;
+  if(!ok)
+    return -1;
+
+  acquire(&ptable.lock);
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->state != UNUSED && (pid == 0 ? p == curproc : p->pid == pid))
+      break;
+  }
+  if(p == &ptable.proc[NPROC]){
+    release(&ptable.lock);
+    return -1;
+  }
+  p->affinity = mask;
+
+  #ifdef STRIDE
+  // Requeue it on a CPU it may still use. A running process is
+  // moved by the scheduler once it gives up the CPU.
+  if(!canrun(p, &cpus[p->cpu])){
+    if(p->state == RUNNABLE)
+      migrate(p, leastloaded(p));
+    else if(p->state != RUNNING)
+      p->cpu = leastloaded(p) - cpus;  // remain is relative, so no fixup
+  }
+  #endif
+  release(&ptable.lock);
+
+  // Get off this CPU right away if the caller may no longer use it
+  if(p == curproc){
+    pushcli();
+    move = !canrun(p, mycpu());
+    popcli();
+    if(move)
+      yield();
+  }
+  return 0;
+}
+
+// Affinity mask of the process with the given pid (0 for the
+// caller), limited to the CPUs that exist, or -1 if there is no
+// such process.
+int
+getaffinity(int pid)
+{
+  struct proc *p, *curproc = myproc();
+  int mask = -1;
+
+  acquire(&ptable.lock);
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->state != UNUSED && (pid == 0 ? p == curproc : p->pid == pid)){
+      mask = p->affinity & ((1 << ncpu) - 1);
+      break;
+    }
+  }
+  release(&ptable.lock);
+  return mask;
+}
+
+// Put the caller in a new ticket group holding the given number of
+// tickets. Children it forks afterwards join the same group.
+// Returns the group id, or -1 if the tickets are out of range.
+int
+setgroup(int tickets)
+{
+  struct proc *curproc = myproc();
+  int g, queued;
+
+  if(tickets < 1)
+    tickets = DEFAULT_TICKETS;
+  else if(tickets > (1 << 5))  // Same cap as settickets()
+    return -1;
+
+  acquire(&ptable.lock);
+  for(g = 0; g < NGROUP; g++)
+    if(ptable.group[g].members == 0)
+      break;
+  if(g == NGROUP){  // Cannot happen: each group has a member
+    release(&ptable.lock);
+    return -1;
+  }
+
+  queued = curproc->weight > 0;
+  if(queued)
+    dequeue(curproc);
+  leavegroup(curproc);
+  ptable.group[g].tickets = tickets;
+  ptable.group[g].runnable = 0;
+  joingroup(curproc, g);
+  if(queued)
+    enqueue(curproc);
+
+  release(&ptable.lock);
+  return g;
+}
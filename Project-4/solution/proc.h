@@ -1,5 +1,20 @@
 #define STRIDE1 (1 << 10)     // Constant for stride calculation
 #define DEFAULT_TICKETS 8      // Default number of tickets
+#define MAXSLICE 4             // Longest stride quantum in ticks
+#define ALLCPUS (~0U)          // Affinity mask that allows every CPU
+#define WEIGHT1 (1 << 8)       // Stride weight units per ticket
+#define NGROUP NPROC           // Maximum number of ticket groups
+
+// MLFQ parameters; each may be overridden from the Makefile
+#ifndef MLFQ_LEVELS
+#define MLFQ_LEVELS 3          // Number of priority levels (0 is highest)
+#endif
+#ifndef MLFQ_QUANTUM
+#define MLFQ_QUANTUM 1         // Ticks allotted at level 0, doubled per level
+#endif
+#ifndef MLFQ_BOOST
+#define MLFQ_BOOST 100         // Ticks between priority boosts
+#endif
 
 // Per-CPU state
 struct cpu {
@@ -11,16 +26,18 @@ struct cpu {
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
   struct proc *proc;           // The process running on this cpu or null
+  int slice;                   // Ticks left in the running process's quantum
+  int tickspan;                // Ticks between this CPU's timer interrupts
+
+  // Stride scheduler run queue state
+  int weight;                  // Sum of weights of processes queued here
+  int stride;                  // STRIDE1*WEIGHT1/weight
+  int pass;                    // Virtual time of this CPU
 };
 
 extern struct cpu cpus[NCPU];
 extern int ncpu;
 
-// Global variables for stride scheduling
-extern int global_tickets;     // Sum of tickets of all runnable processes
-extern int global_stride;      // STRIDE1/global_tickets
-extern int global_pass;        // Global pass value
-
 //PAGEBREAK: 17
 // Saved registers for kernel context switches.
 // Don't need to save all the segment registers (%cs, etc),
@@ -53,6 +70,7 @@ struct proc {
   struct trapframe *tf;        // Trap frame for current syscall
   struct context *context;     // swtch() here to run process
   void *chan;                  // If non-zero, sleeping on chan
+  struct proc *qnext;          // Next process in the same sleep queue
   int killed;                  // If non-zero, have been killed
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
@@ -63,10 +81,33 @@ struct proc {
   int stride;                  // Calculated as STRIDE1/tickets
   int pass;                    // Pass value for stride scheduling
   int remain;                  // Remaining value when process state changes
+  int weight;                  // Effective tickets*WEIGHT1 while queued, else 0
+  int group;                   // Ticket group, or -1
   int rtime;                   // Total running time in ticks
+  uint64 cycles;               // Time actually run, in TSC cycles
+  int switches;                // Times switched in by the scheduler
+
+  // CPU placement
+  int cpu;                     // CPU whose stride run queue it is on
+  uint affinity;               // Bit i set if it may run on cpus[i]
+  int lastcpu;                 // CPU it last ran on, or -1
+  int migrations;              // Times it ran on a different CPU than before
+
+  // MLFQ scheduler specific fields
+  int level;                   // Current priority level
+  int qticks;                  // Ticks used at the current level
+  uint qseq;                   // Queue position within the level (FIFO)
+};
+
+// Ticket group: a pool of tickets shared by its member processes
+struct group {
+  int tickets;                 // Tickets of the group as a whole
+  int members;                 // Member processes; 0 if the slot is free
+  int runnable;                // Sum of tickets of its queued members
 };
 
 // Function declarations for stride scheduler
+struct pstat;
 int settickets(int number);
 int getpinfo(struct pstat* ps);
 
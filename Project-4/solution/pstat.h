@@ -13,6 +13,11 @@ struct pstat {
   int remain[NPROC];     // Remaining pass value for each process
   int stride[NPROC];     // Stride value for each process
   int rtime[NPROC];      // Total running time of each process
+  int level[NPROC];      // MLFQ priority level of each process
+  uint64 cycles[NPROC];  // CPU time of each process in TSC cycles
+  int switches[NPROC];   // Number of times each process was switched in
+  int migrations[NPROC]; // Times each process ran on a different CPU than before
+  int group[NPROC];      // Ticket group of each process, or -1
 };
 
 #endif // _PSTAT_H_
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Measures how quickly interactive (sleep-heavy) processes get the CPU
+// back while CPU-bound processes keep every CPU busy. Compare the
+// output across SCHEDULER=RR, STRIDE and MLFQ builds.
+
+#define CPU_PROCESSES 6
+#define INTERACTIVE_PROCESSES 2
+#define ROUNDS 50
+#define BURST 100000
+
+void spin(void);
+void interactive(int id);
+
+int main() {
+  int i;
+  int pid;
+  int hogs[CPU_PROCESSES];
+
+  printf(1, "Starting %d CPU-bound processes.\n", CPU_PROCESSES);
+  for (i = 0; i < CPU_PROCESSES; i++) {
+    pid = fork();
+    if (pid < 0) {
+      printf(1, "Fork failed\n");
+      exit();
+    }
+    else if (pid == 0) {
+      spin();
+      exit();
+    }
+    hogs[i] = pid;
+  }
+
+  // Let the CPU-bound processes sink to the lower levels first
+  sleep(20);
+
+  printf(1, "Starting %d interactive processes.\n", INTERACTIVE_PROCESSES);
+  for (i = 0; i < INTERACTIVE_PROCESSES; i++) {
+    pid = fork();
+    if (pid < 0) {
+      printf(1, "Fork failed\n");
+      exit();
+    }
+    else if (pid == 0) {
+      interactive(i);
+      exit();
+    }
+  }
+
+  for (i = 0; i < INTERACTIVE_PROCESSES; i++) {
+    wait();
+  }
+
+  for (i = 0; i < CPU_PROCESSES; i++) {
+    kill(hogs[i]);
+  }
+  for (i = 0; i < CPU_PROCESSES; i++) {
+    wait();
+  }
+  printf(1, "All child processes have completed.\n");
+  exit();
+}
+
+void spin(void) {
+  volatile int i;
+  for (;;) {
+    for (i = 0; i < BURST; i++) {
+      // Busy-wait loop to consume CPU time
+    }
+  }
+}
+
+// Sleep for one tick at a time and record how many extra ticks pass
+// before the process runs again. sleep(1) returns on the first tick
+// boundary, so anything beyond one tick is scheduling delay.
+void interactive(int id) {
+  volatile int j;
+  int r, t0, delay;
+  int total = 0;
+  int worst = 0;
+
+  for (r = 0; r < ROUNDS; r++) {
+    t0 = uptime();
+    sleep(1);
+    delay = uptime() - t0 - 1;
+    if (delay < 0)
+      delay = 0;
+    total += delay;
+    if (delay > worst)
+      worst = delay;
+
+    // Short burst of work, as if handling the input
+    for (j = 0; j < BURST / 10; j++) {
+    }
+  }
+
+  printf(1, "interactive %d (pid %d): avg response %d.%d ticks, max %d ticks\n",
+         id, getpid(), total / ROUNDS, (total * 10 / ROUNDS) % 10, worst);
+}
@@ -0,0 +1,200 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "pstat.h"
+#include "schedutil.h"
+
+// Scheduler benchmark. Runs CPU-bound processes with varied tickets next
+// to processes that alternate short bursts with sleeps, samples getpinfo()
+// while they run and reports throughput, context switch rate and the
+// largest deviation of the CPU-bound processes from their ideal
+// proportional share.
+//
+// usage: schedbench [cpu-bound] [io-bound] [ticks]
+// tests/run-bench.sh runs it with CPUS=1, 2 and 4.
+
+#define DEFAULT_CPU 6
+#define DEFAULT_IO 2
+#define DEFAULT_TICKS 500
+#define SAMPLE_TICKS 50
+#define MAXCHILD 32
+#define BURST 100000
+#define IO_TICKETS 8
+#define PREFIX "BENCH"
+
+int ticket_values[] = {1, 2, 4, 8, 16, 32};
+
+struct child {
+  int pid;
+  int tickets;
+  int cpubound;
+  int units;                   // Work done, reported through the pipe
+  uint64 cycles;               // Cycles at the last sample
+  int switches;                // Switches at the last sample
+};
+
+struct child children[MAXCHILD];
+int nchild;
+
+void work(int cpubound, int deadline, int fd);
+int sample(struct pstat *ps, int *deviation);
+
+int main(int argc, char *argv[]) {
+  int i, pid, ncpu, nio, ticks, deadline, start;
+  int fds[2];
+  int report[2];
+  int interval_err, worst_interval = 0;
+  int total_err, switches;
+  int cpu_units = 0, io_units = 0;
+  struct pstat ps;
+
+  ncpu = argc > 1 ? atoi(argv[1]) : DEFAULT_CPU;
+  nio = argc > 2 ? atoi(argv[2]) : DEFAULT_IO;
+  ticks = argc > 3 ? atoi(argv[3]) : DEFAULT_TICKS;
+  if (ncpu < 1 || nio < 0 || ncpu + nio > MAXCHILD || ticks < SAMPLE_TICKS) {
+    printf(1, "usage: schedbench [cpu-bound] [io-bound] [ticks]\n");
+    exit();
+  }
+
+  if (pipe(fds) < 0) {
+    printf(1, "pipe failed\n");
+    exit();
+  }
+
+  printf(1, "%s: %d cpu-bound, %d io-bound, %d ticks\n", PREFIX, ncpu, nio, ticks);
+  start = uptime();
+  deadline = start + ticks;
+  for (i = 0; i < ncpu + nio; i++) {
+    struct child *ch = &children[nchild];
+    ch->cpubound = i < ncpu;
+    ch->tickets = ch->cpubound ?
+      ticket_values[i % (sizeof(ticket_values) / sizeof(ticket_values[0]))] :
+      IO_TICKETS;
+    pid = fork();
+    if (pid < 0) {
+      printf(1, "Fork failed\n");
+      exit();
+    }
+    else if (pid == 0) {
+      close(fds[0]);
+      settickets(ch->tickets);
+      work(ch->cpubound, deadline, fds[1]);
+      exit();
+    }
+    ch->pid = pid;
+    nchild++;
+  }
+  close(fds[1]);
+
+  // First sample is the baseline; the rest each cover one interval
+  sample(&ps, 0);
+  while (uptime() + SAMPLE_TICKS <= deadline) {
+    sleep(SAMPLE_TICKS);
+    interval_err = sample(&ps, 0);
+    if (interval_err > worst_interval)
+      worst_interval = interval_err;
+  }
+
+  // Collect the work counters, then measure the whole run once more
+  for (i = 0; i < nchild; i++) {
+    if (read(fds[0], report, sizeof(report)) != sizeof(report))
+      break;
+    for (pid = 0; pid < nchild; pid++) {
+      if (children[pid].pid == report[0])
+        children[pid].units = report[1];
+    }
+  }
+  close(fds[0]);
+
+  for (i = 0; i < nchild; i++) {
+    children[i].cycles = 0;
+    children[i].switches = 0;
+    if (children[i].cpubound)
+      cpu_units += children[i].units;
+    else
+      io_units += children[i].units;
+  }
+  switches = sample(&ps, &total_err);
+  ticks = uptime() - start;
+
+  for (i = 0; i < nchild; i++) {
+    wait();
+  }
+
+  printf(1, "%s: throughput %d cpu units/tick, %d io rounds/tick\n",
+         PREFIX, cpu_units / ticks, io_units / ticks);
+  printf(1, "%s: context switches %d (%d per 100 ticks)\n",
+         PREFIX, switches, switches * 100 / ticks);
+  printf(1, "%s: max share deviation over run ", PREFIX);
+  printfixed(total_err);
+  printf(1, "%%, worst %d-tick interval ", SAMPLE_TICKS);
+  printfixed(worst_interval);
+  printf(1, "%%\n");
+  exit();
+}
+
+// Run until the deadline, then report the work done as {pid, units}.
+void work(int cpubound, int deadline, int fd) {
+  volatile int j;
+  int report[2];
+
+  report[0] = getpid();
+  report[1] = 0;
+  while (uptime() < deadline) {
+    for (j = 0; j < (cpubound ? BURST : BURST / 10); j++) {
+      // Busy-wait loop to consume CPU time
+    }
+    if (!cpubound)
+      sleep(1);
+    report[1]++;
+  }
+  write(fd, report, sizeof(report));
+}
+
+// Take a getpinfo() sample and compare each CPU-bound child's share of
+// the cycles since the previous sample with its share of the tickets.
+// Returns the largest deviation in thousandths. If deviation is non-null
+// the deviation is stored there instead, and the number of context
+// switches since the previous sample is returned.
+int sample(struct pstat *ps, int *deviation) {
+  int i, j, err, worst = 0, switches = 0, tickets = 0;
+  uint64 total = 0;
+  uint64 delta[MAXCHILD];
+
+  if (getpinfo(ps) != 0) {
+    printf(1, "Failed to get process info\n");
+    exit();
+  }
+
+  for (i = 0; i < nchild; i++) {
+    delta[i] = 0;
+    for (j = 0; j < NPROC; j++) {
+      if (ps->inuse[j] && ps->pid[j] == children[i].pid) {
+        delta[i] = ps->cycles[j] - children[i].cycles;
+        switches += ps->switches[j] - children[i].switches;
+        children[i].cycles = ps->cycles[j];
+        children[i].switches = ps->switches[j];
+      }
+    }
+    if (children[i].cpubound) {
+      total += delta[i];
+      tickets += children[i].tickets;
+    }
+  }
+
+  for (i = 0; i < nchild; i++) {
+    if (!children[i].cpubound)
+      continue;
+    err = permille(delta[i], total) - children[i].tickets * 1000 / tickets;
+    if (err < 0)
+      err = -err;
+    if (err > worst)
+      worst = err;
+  }
+
+  if (deviation) {
+    *deviation = worst;
+    return switches;
+  }
+  return worst;
+}
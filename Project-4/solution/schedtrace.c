@@ -0,0 +1,161 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "schedtrace.h"
+#include "schedutil.h"
+
+// Drains the kernel's scheduling event trace for a while and reports,
+// per process, its share of the CPU, how long it waited while runnable
+// and how far its share is from what its tickets entitle it to.
+//
+// usage: schedtrace [ticks]
+// Start the workload first, e.g. "workload &; schedtrace 300".
+
+#define DEFAULT_TICKS 300
+#define NEVENTS 512
+#define MAXTRACKED NPROC
+
+struct tracked {
+  int pid;
+  int tickets;
+  int slept;                   // Went to sleep during the window
+  int dispatches;              // Times it was switched in
+  uint64 run;                  // Cycles spent running
+  uint64 wait;                 // Cycles spent runnable but not running
+  uint64 lastin;               // When it was last switched in, or 0
+  uint64 ready;                // When it last became runnable, or 0
+};
+
+struct tracked procs[MAXTRACKED];
+struct schedevent buf[NEVENTS];
+int lost;
+
+struct tracked* lookup(int pid);
+void account(struct schedevent *e);
+
+int main(int argc, char *argv[]) {
+  int i, n, start, ticks;
+  int self = getpid();
+  int fairmax = 0;
+  int fairtickets = 0;
+  uint64 total = 0;
+  uint64 fairtotal = 0;
+  struct tracked *t;
+
+  ticks = DEFAULT_TICKS;
+  if (argc > 1)
+    ticks = atoi(argv[1]);
+
+  // Throw away whatever was buffered before we started
+  while (gettrace(buf, NEVENTS) == NEVENTS)
+    ;
+
+  start = uptime();
+  while (uptime() - start < ticks) {
+    do {
+      n = gettrace(buf, NEVENTS);
+      if (n < 0) {
+        printf(1, "gettrace failed\n");
+        exit();
+      }
+      for (i = 0; i < n; i++)
+        account(&buf[i]);
+    } while (n == NEVENTS);
+    sleep(5);
+  }
+
+  for (i = 0; i < MAXTRACKED; i++) {
+    t = &procs[i];
+    if (t->pid == 0 || t->pid == self)
+      continue;
+    total += t->run;
+    // Only processes that stayed runnable the whole time compete
+    // for the CPU, so only they are held to their ticket ratio.
+    if (!t->slept && t->run > 0) {
+      fairtotal += t->run;
+      fairtickets += t->tickets;
+    }
+  }
+
+  printf(1, "Trace over %d ticks", ticks);
+  if (lost)
+    printf(1, " (%d events lost, increase sampling rate)", lost);
+  printf(1, "\n");
+  printf(1, "PID\tTickets\tCPU%%\tWait(Kcyc)\tAvgWait\tFairErr%%\n");
+  for (i = 0; i < MAXTRACKED; i++) {
+    t = &procs[i];
+    if (t->pid == 0 || t->pid == self)
+      continue;
+    printf(1, "%d\t%d\t", t->pid, t->tickets);
+    printfixed(permille(t->run, total));
+    printf(1, "\t%d\t\t%d\t", (uint)(t->wait >> 10),
+           t->dispatches ? (uint)(t->wait >> 10) / t->dispatches : 0);
+    if (!t->slept && t->run > 0) {
+      int err = permille(t->run, fairtotal) - t->tickets * 1000 / fairtickets;
+      printfixed(err);
+      if (err < 0)
+        err = -err;
+      if (err > fairmax)
+        fairmax = err;
+    } else {
+      printf(1, "-");
+    }
+    printf(1, "\n");
+  }
+  printf(1, "Max fairness error: ");
+  printfixed(fairmax);
+  printf(1, "%%\n");
+  exit();
+}
+
+struct tracked* lookup(int pid) {
+  int i;
+  struct tracked *slot = 0;
+
+  for (i = 0; i < MAXTRACKED; i++) {
+    if (procs[i].pid == pid)
+      return &procs[i];
+    if (slot == 0 && procs[i].pid == 0)
+      slot = &procs[i];
+  }
+  if (slot) {
+    memset(slot, 0, sizeof(*slot));
+    slot->pid = pid;
+  }
+  return slot;
+}
+
+void account(struct schedevent *e) {
+  struct tracked *t;
+
+  if (e->type == SCHED_LOST) {
+    lost += e->arg;
+    return;
+  }
+  if ((t = lookup(e->pid)) == 0)
+    return;
+  t->tickets = e->tickets;
+
+  switch (e->type) {
+  case SCHED_WAKEUP:
+    t->ready = e->tsc;
+    break;
+  case SCHED_SWITCHIN:
+    if (t->ready)
+      t->wait += e->tsc - t->ready;
+    t->ready = 0;
+    t->lastin = e->tsc;
+    t->dispatches++;
+    break;
+  case SCHED_SWITCHOUT:
+    if (t->lastin)
+      t->run += e->tsc - t->lastin;
+    t->lastin = 0;
+    if (e->arg == SCHED_OUT_RUNNABLE)
+      t->ready = e->tsc;
+    break;
+  case SCHED_SLEEP:
+    t->slept = 1;
+    break;
+  }
+}
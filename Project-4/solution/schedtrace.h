@@ -0,0 +1,29 @@
+// schedtrace.h
+
+#ifndef _SCHEDTRACE_H_
+#define _SCHEDTRACE_H_
+
+#define NSCHEDEV 512           // Events buffered per CPU
+
+// Event types
+#define SCHED_SWITCHIN  1      // Process was picked to run
+#define SCHED_SWITCHOUT 2      // Process gave the CPU back
+#define SCHED_SLEEP     3      // Process went to sleep
+#define SCHED_WAKEUP    4      // Process became runnable
+#define SCHED_LOST      5      // Ring overflowed; arg events were dropped
+
+// States a SWITCHOUT event's arg reports the process left the CPU in
+#define SCHED_OUT_RUNNABLE 1   // Preempted or yielded, still runnable
+#define SCHED_OUT_SLEEPING 2   // Blocked
+#define SCHED_OUT_EXITED   3   // Exited
+
+struct schedevent {
+  uint64 tsc;                  // Time stamp counter when the event happened
+  int type;                    // One of the SCHED_* types above
+  int cpu;                     // CPU that recorded the event
+  int pid;                     // Process the event is about
+  int tickets;                 // Its tickets at the time
+  int arg;                     // SWITCHOUT: SCHED_OUT_*, LOST: events dropped
+};
+
+#endif // _SCHEDTRACE_H_
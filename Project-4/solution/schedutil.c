@@ -0,0 +1,25 @@
+// Fixed-point helpers shared by schedtrace and schedbench.
+
+#include "types.h"
+#include "user.h"
+#include "schedutil.h"
+
+// part/whole in thousandths, without 64-bit division
+int permille(uint64 part, uint64 whole) {
+  while (whole >= (1 << 22)) {
+    part >>= 1;
+    whole >>= 1;
+  }
+  if (whole == 0)
+    return 0;
+  return (uint)part * 1000 / (uint)whole;
+}
+
+// Print thousandths as a percentage with one decimal
+void printfixed(int permille) {
+  if (permille < 0) {
+    printf(1, "-");
+    permille = -permille;
+  }
+  printf(1, "%d.%d", permille / 10, permille % 10);
+}
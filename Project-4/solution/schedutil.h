@@ -0,0 +1,9 @@
+// schedutil.h: helpers shared by schedtrace and schedbench (schedutil.c)
+
+#ifndef _SCHEDUTIL_H_
+#define _SCHEDUTIL_H_
+
+int permille(uint64 part, uint64 whole);
+void printfixed(int permille);
+
+#endif // _SCHEDUTIL_H_
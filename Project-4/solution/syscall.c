@@ -108,6 +108,10 @@ extern int sys_uptime(void);
 
 extern int sys_settickets(void);
 extern int sys_getpinfo(void);
+extern int sys_gettrace(void);
+extern int sys_setaffinity(void);
+extern int sys_getaffinity(void);
+extern int sys_setgroup(void);
 
 static int (*syscalls[])(void) = {
   [SYS_fork]    sys_fork,
@@ -133,6 +137,10 @@ static int (*syscalls[])(void) = {
   [SYS_close]   sys_close,
   [SYS_settickets] sys_settickets,
   [SYS_getpinfo]   sys_getpinfo,
+  [SYS_gettrace]   sys_gettrace,
+  [SYS_setaffinity] sys_setaffinity,
+  [SYS_getaffinity] sys_getaffinity,
+  [SYS_setgroup]   sys_setgroup,
 };
 
 void
@@ -27,5 +27,9 @@
 #define SYS_close   21
 #define SYS_settickets 22
 #define SYS_getpinfo   23
+#define SYS_gettrace   24
+#define SYS_setaffinity 25
+#define SYS_getaffinity 26
+#define SYS_setgroup   27
 
 #endif // SYSCALL_H
\ No newline at end of file
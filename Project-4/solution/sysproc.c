@@ -9,6 +9,7 @@
 #include "mmu.h"
 #include "proc.h"
 #include "pstat.h"
+#include "schedtrace.h"
 
 int
 sys_fork(void)
@@ -109,4 +110,48 @@ sys_getpinfo(void)
   if(argptr(0, (char**)&ps, sizeof(struct pstat)) < 0)
     return -1;
   return getpinfo(ps);
+}
+
+// Drain buffered scheduling events into a user array
+int
+sys_gettrace(void)
+{
+  struct schedevent *ev;
+  int n;
+
+  if(argint(1, &n) < 0 || n < 0)
+    return -1;
+  if(argptr(0, (char**)&ev, n * sizeof(*ev)) < 0)
+    return -1;
+  return gettrace(ev, n);
+}
+
+int
+sys_setaffinity(void)
+{
+  int pid, mask;
+
+  if(argint(0, &pid) < 0 || argint(1, &mask) < 0)
+    return -1;
+  return setaffinity(pid, mask);
+}
+
+int
+sys_getaffinity(void)
+{
+  int pid;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  return getaffinity(pid);
+}
+
+int
+sys_setgroup(void)
+{
+  int n;
+
+  if(argint(0, &n) < 0)
+    return -1;
+  return setgroup(n);
 }
\ No newline at end of file
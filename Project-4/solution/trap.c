@@ -13,6 +13,8 @@ struct gatedesc idt[256];
 extern uint vectors[];  // in vectors.S: array of 256 entry pointers
 struct spinlock tickslock;
 uint ticks;
+uint tickcycles;        // TSC cycles per tick, measured on cpu 0
+static uint64 lasttick; // TSC at the previous tick
 
 void
 tvinit(void)
@@ -49,6 +51,16 @@ trap(struct trapframe *tf)
   switch(tf->trapno){
   case T_IRQ0 + IRQ_TIMER:
     if(cpuid() == 0){
+      uint64 now = rdtsc();
+      if(lasttick){
+        // Smooth out interrupt latency with a running average
+        if(tickcycles)
+          tickcycles = tickcycles - tickcycles/8 + (uint)(now - lasttick)/8;
+        else
+          tickcycles = now - lasttick;
+      }
+      lasttick = now;
+
       acquire(&tickslock);
       ticks++;
       wakeup(&ticks);
@@ -100,10 +112,11 @@ trap(struct trapframe *tf)
   if(myproc() && myproc()->killed && (tf->cs&3) == DPL_USER)
     exit();
 
-  // Force process to give up CPU on clock tick.
+  // Force process to give up CPU once its quantum is used up.
   // If interrupts were on while locks held, would need to check nlock.
   if(myproc() && myproc()->state == RUNNING &&
-     tf->trapno == T_IRQ0+IRQ_TIMER)
+     tf->trapno == T_IRQ0+IRQ_TIMER &&
+     (mycpu()->slice -= mycpu()->tickspan) <= 0)
     yield();
 
   // Check if the process has been killed since we yielded
@@ -3,6 +3,7 @@
 #include "pstat.h"  // Include pstat.h for struct pstat
 
 struct stat;
+struct schedevent;
 struct rtcdate;
 
 // system calls
@@ -29,6 +30,10 @@ int sleep(int);
 int uptime(void);
 int settickets(int);         // Add new syscall declaration
 int getpinfo(struct pstat*); // Add new syscall declaration
+int gettrace(struct schedevent*, int);
+int setaffinity(int, int);
+int getaffinity(int);
+int setgroup(int);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -0,0 +1,127 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+// Sleep/wakeup microbenchmark. Two processes bounce a byte back and
+// forth over a pair of pipes, so every round trip is two sleeps and
+// two wakeups. The rate is measured first on a quiet system and then
+// with many other processes asleep on channels of their own, which
+// wakeup() should not have to look at.
+//
+// usage: wakebench [sleepers] [ticks]
+
+#define DEFAULT_SLEEPERS 40
+#define DEFAULT_TICKS 100
+#define MAXSLEEPERS 50
+#define PREFIX "WAKE"
+
+int pingpong(int ticks);
+void chain(int n, int fd);
+
+int main(int argc, char *argv[]) {
+  int pid, nsleep, ticks, quiet, busy;
+  int fds[2];
+
+  nsleep = argc > 1 ? atoi(argv[1]) : DEFAULT_SLEEPERS;
+  ticks = argc > 2 ? atoi(argv[2]) : DEFAULT_TICKS;
+  if (nsleep < 0 || nsleep > MAXSLEEPERS || ticks < 1) {
+    printf(1, "usage: wakebench [sleepers] [ticks]\n");
+    exit();
+  }
+
+  quiet = pingpong(ticks);
+  printf(1, "%s: %d round trips/tick with no other sleepers\n", PREFIX, quiet);
+
+  if (pipe(fds) < 0) {
+    printf(1, "pipe failed\n");
+    exit();
+  }
+  if (nsleep > 0) {
+    pid = fork();
+    if (pid < 0) {
+      printf(1, "Fork failed\n");
+      exit();
+    }
+    else if (pid == 0) {
+      close(fds[1]);
+      chain(nsleep, fds[0]);
+      exit();
+    }
+  }
+  close(fds[0]);
+
+  // Give the chain time to fork and go to sleep
+  sleep(10);
+  busy = pingpong(ticks);
+  printf(1, "%s: %d round trips/tick with %d other sleepers\n",
+         PREFIX, busy, nsleep);
+
+  // Closing the pipe lets the end of the chain exit, which unwinds it
+  close(fds[1]);
+  if (nsleep > 0)
+    wait();
+  exit();
+}
+
+// Build a chain of n processes, each asleep in wait() for the next
+// one, so each sleeps on a channel of its own. The last blocks
+// reading fd until the write end is closed.
+void chain(int n, int fd) {
+  int pid;
+  char c;
+
+  if (n > 1) {
+    pid = fork();
+    if (pid == 0) {
+      chain(n - 1, fd);
+      exit();
+    }
+    if (pid > 0) {
+      wait();
+      return;
+    }
+  }
+  read(fd, &c, 1);
+}
+
+// Bounce a byte with a child for the given number of ticks and
+// return the number of round trips per tick.
+int pingpong(int ticks) {
+  int pid, start, rounds = 0;
+  int ping[2], pong[2];
+  char c = 0;
+
+  if (pipe(ping) < 0 || pipe(pong) < 0) {
+    printf(1, "pipe failed\n");
+    exit();
+  }
+
+  pid = fork();
+  if (pid < 0) {
+    printf(1, "Fork failed\n");
+    exit();
+  }
+  else if (pid == 0) {
+    close(ping[1]);
+    close(pong[0]);
+    while (read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit();
+  }
+  close(ping[0]);
+  close(pong[1]);
+
+  start = uptime();
+  while (uptime() - start < ticks) {
+    write(ping[1], &c, 1);
+    if (read(pong[0], &c, 1) != 1)
+      break;
+    rounds++;
+  }
+  ticks = uptime() - start;
+
+  close(ping[1]);
+  close(pong[0]);
+  wait();
+  return rounds / (ticks ? ticks : 1);
+}
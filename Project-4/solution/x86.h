@@ -117,6 +117,20 @@ sti(void)
   asm volatile("sti");
 }
 
+static inline void
+hlt(void)
+{
+  asm volatile("hlt");
+}
+
+static inline uint64
+rdtsc(void)
+{
+  uint64 val;
+  asm volatile("rdtsc" : "=A" (val));
+  return val;
+}
+
 static inline uint
 xchg(volatile uint *addr, uint newval)
 {
@@ -0,0 +1,20 @@
+#! /usr/bin/env bash
+
+# Run the schedbench suite with 1, 2 and 4 CPUs and keep its reports
+# in bench-out/ so scheduler changes can be compared.
+# usage: run-bench.sh [RR|STRIDE|MLFQ]
+
+sched=${1:-STRIDE}
+
+if [[ ! -d bench-out ]]; then
+    mkdir bench-out
+fi
+
+for cpus in 1 2 4; do
+    echo "SCHEDULER=$sched CPUS=$cpus"
+    cd ../solution
+    make clean > /dev/null
+    ../tests/run-xv6-command.exp CPUS=$cpus SCHEDULER=$sched Makefile schedbench \
+        | grep -E 'BENCH' | tee ../tests/bench-out/$sched-$cpus.out
+    cd ../tests
+done
@@ -0,0 +1,47 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "pstat.h"
+#include "test_helper.h"
+
+int
+main(int argc, char* argv[])
+{
+    struct pstat ps;
+
+    // Run with CPUS=2, so every process starts out allowed on both
+    ASSERT(getaffinity(0) == 3, "Default affinity is %d instead of 3",
+            getaffinity(0));
+    ASSERT(getaffinity(getpid()) == 3, "getaffinity by pid does not match");
+    ASSERT(getaffinity(100000) == -1, "getaffinity of a missing pid succeeded");
+
+    ASSERT(setaffinity(0, 0) == -1, "Empty affinity mask was accepted");
+    ASSERT(setaffinity(0, 1 << 5) == -1, "Mask of a CPU that is not \
+running was accepted");
+
+    ASSERT(setaffinity(0, 2) == 0, "setaffinity syscall failed");
+    ASSERT(getaffinity(0) == 2, "Affinity is %d after pinning to CPU 1",
+            getaffinity(0));
+
+    int pid = fork();
+    if (pid == 0) {
+        ASSERT(getaffinity(0) == 2, "Child did not inherit the affinity mask");
+        exit();
+    }
+    wait();
+
+    // Once pinned, the process must stay on one CPU
+    int my_idx = find_my_stats_index(&ps);
+    ASSERT(my_idx != -1, "Could not get process stats from pgetinfo");
+    int old_migrations = ps.migrations[my_idx];
+    run_until(ps.rtime[my_idx] + 20);
+
+    my_idx = find_my_stats_index(&ps);
+    ASSERT(my_idx != -1, "Could not get process stats from pgetinfo");
+    ASSERT(ps.migrations[my_idx] == old_migrations, "Pinned process \
+migrated %d times", ps.migrations[my_idx] - old_migrations);
+
+    test_passed();
+
+    exit();
+}
@@ -0,0 +1,50 @@
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "pstat.h"
+#include "test_helper.h"
+
+int
+main(int argc, char* argv[])
+{
+    struct pstat ps;
+
+    int my_idx = find_my_stats_index(&ps);
+    ASSERT(my_idx != -1, "Could not get process stats from pgetinfo");
+    ASSERT(ps.group[my_idx] == -1, "Process starts out in group %d",
+            ps.group[my_idx]);
+
+    ASSERT(setgroup(1 << 6) == -1, "setgroup accepted too many tickets");
+
+    int gid = setgroup(DEFAULT_TICKETS);
+    ASSERT(gid >= 0, "setgroup syscall failed");
+
+    int pid = fork();
+    if (pid == 0) {
+        run_until(1000);
+        exit();
+    }
+
+    // Let the child get on the CPU, then both should be in the group
+    run_until(ps.rtime[my_idx] + 10);
+    my_idx = find_my_stats_index(&ps);
+    ASSERT(my_idx != -1, "Could not get process stats from pgetinfo");
+    int ch_idx = find_stats_index_for_pid(&ps, pid);
+    ASSERT(ch_idx != -1, "Could not get child process stats from pgetinfo");
+
+    ASSERT(ps.group[my_idx] == gid, "Parent is in group %d instead of %d",
+            ps.group[my_idx], gid);
+    ASSERT(ps.group[ch_idx] == gid, "Child did not inherit group %d", gid);
+
+    // Two runnable members split the group's tickets, so each runs
+    // at half of what its own tickets would give it
+    ASSERT(ps.stride[my_idx] == 2 * (1 << 10) / DEFAULT_TICKETS, "Stride of \
+a group member is %d with two members runnable", ps.stride[my_idx]);
+
+    kill(pid);
+    wait();
+
+    test_passed();
+
+    exit();
+}
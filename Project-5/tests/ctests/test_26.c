@@ -0,0 +1,78 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_26
+// Summary: HUGE: 4MB-aligned anonymous map is backed by 4MB pages
+// ====================================================================
+
+char *test_name = "TEST_26";
+
+#define HUGEPGSIZE (PGSIZE * 1024)
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    //
+    // Place a huge anonymous map of two 4MB chunks plus a page
+    //
+    uint addr = MMAPBASE;
+    uint length = HUGEPGSIZE * 2 + PGSIZE;
+    int flags = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED | MAP_HUGE;
+    uint map = wmap(addr, length, flags, -1);
+    if (map != addr) {
+        printerr("wmap() returned %d\n", (int)map);
+        failed();
+    }
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 1);
+    map_exists(&winfo, map, length, TRUE);
+    printf(1, "INFO: Map 1 at 0x%x with length 0x%x. \tOkay.\n", map, length);
+
+    //
+    // Touch one byte in the first chunk; the whole chunk is loaded
+    //
+    char *arr = (char *)map;
+    arr[PGSIZE * 3] = 'a';
+    get_n_validate_wmap_info(&winfo, 1);
+    if (winfo.n_huge_pages[0] != 1 || winfo.n_loaded_pages[0] != 1024) {
+        printerr("expected 1 huge page and 1024 loaded pages, got %d and %d\n",
+                 winfo.n_huge_pages[0], winfo.n_loaded_pages[0]);
+        failed();
+    }
+    uint pa = va2pa(map);
+    if (pa == FAILED || pa % HUGEPGSIZE != 0 || va2pa(map + PGSIZE * 3) != pa + PGSIZE * 3) {
+        printerr("va2pa of the huge page returned 0x%x\n", pa);
+        failed();
+    }
+    printf(1, "INFO: First chunk is a 4MB page at pa 0x%x. \tOkay.\n", pa);
+
+    //
+    // The trailing page does not fill a chunk and uses a 4KB page
+    //
+    arr[HUGEPGSIZE * 2] = 'b';
+    get_n_validate_wmap_info(&winfo, 1);
+    if (winfo.n_huge_pages[0] != 1 || winfo.n_loaded_pages[0] != 1025) {
+        printerr("expected 1 huge page and 1025 loaded pages, got %d and %d\n",
+                 winfo.n_huge_pages[0], winfo.n_loaded_pages[0]);
+        failed();
+    }
+    for (int i = 0; i < HUGEPGSIZE; i += PGSIZE) {
+        if (arr[i] != (i == PGSIZE * 3 ? 'a' : 0)) {
+            printerr("arr[%d] = %d\n", i, arr[i]);
+            failed();
+        }
+    }
+    printf(1, "INFO: Trailing page uses a 4KB page. \tOkay.\n");
+
+    int ret = wunmap(map);
+    if (ret < 0) {
+        printerr("wunmap() returned %d\n", ret);
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 0);
+    map_exists(&winfo, map, length, FALSE);
+    printf(1, "INFO: Map 1 unmapped. \tOkay.\n");
+
+    success();
+}
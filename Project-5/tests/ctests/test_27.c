@@ -0,0 +1,62 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_27
+// Summary: READAHEAD: Sequential scan of a filebacked map takes fewer faults
+// ====================================================================
+
+char *test_name = "TEST_27";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    char *filename = "seqfile";
+    int N_PAGES = 16;
+    int val = 10;
+    int filelen = create_big_file(filename, N_PAGES, val);
+
+    //
+    // Map the whole file
+    //
+    int fd = open_file(filename, filelen);
+    uint map = wmap(MMAPBASE, filelen, MAP_FIXED | MAP_SHARED, fd);
+    if (map != MMAPBASE) {
+        printerr("wmap() returned %d\n", (int)map);
+        failed();
+    }
+    close(fd);
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 1);
+    map_allocated(&winfo, map, filelen, 0);
+    printf(1, "INFO: Map 1 at 0x%x with length 0x%x. \tOkay.\n", map, filelen);
+
+    //
+    // Read every byte in order
+    //
+    char *arr = (char *)map;
+    for (int i = 0; i < filelen; i++) {
+        if (arr[i] != val + i / PGSIZE) {
+            printerr("addr 0x%x contains %d, expected %d\n", map + i, arr[i],
+                     val + i / PGSIZE);
+            failed();
+        }
+    }
+    printf(1, "INFO: Read %d pages in order. \tOkay.\n", N_PAGES);
+
+    //
+    // Every page is loaded, most of them without a fault of their own
+    //
+    get_n_validate_wmap_info(&winfo, 1);
+    map_allocated(&winfo, map, filelen, N_PAGES);
+    printf(1, "INFO: %d faults, %d faults saved\n", winfo.n_faults[0],
+           winfo.n_faults_saved[0]);
+    if (winfo.n_faults[0] >= N_PAGES / 2 ||
+        winfo.n_faults[0] + winfo.n_faults_saved[0] != N_PAGES) {
+        printerr("expected read-ahead to cover most of the %d pages\n", N_PAGES);
+        failed();
+    }
+    printf(1, "INFO: Read-ahead covered the scan. \tOkay.\n");
+
+    success();
+}
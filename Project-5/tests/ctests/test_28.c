@@ -0,0 +1,95 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_28
+// Summary: WMSYNC: Modified page is written back without unmapping
+// ====================================================================
+
+char *test_name = "TEST_28";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    char *filename = "sync.txt";
+    int N_PAGES = 3;
+    char val = 20;
+    int filelen = create_big_file(filename, N_PAGES, val);
+
+    //
+    // Map the file and modify its second page only
+    //
+    int fd = open_file(filename, filelen);
+    uint map = wmap(MMAPBASE, filelen, MAP_FIXED | MAP_SHARED, fd);
+    if (map != MMAPBASE) {
+        printerr("wmap() returned %d\n", (int)map);
+        failed();
+    }
+    close(fd);
+    char *arr = (char *)map;
+    for (int i = 0; i < PGSIZE; i++) {
+        arr[PGSIZE + i] = 'x';
+    }
+    printf(1, "INFO: Modified page 1. \tOkay.\n");
+
+    //
+    // Flush the mapping while it stays in place; only the modified
+    // page is written back
+    //
+    struct meminfo before, mi;
+    get_my_meminfo(&before);
+    int ret = wmsync(map, filelen);
+    if (ret < 0) {
+        printerr("wmsync() returned %d\n", ret);
+        failed();
+    }
+    get_my_meminfo(&mi);
+    if (mi.writeback != before.writeback + 1) {
+        printerr("%d pages written back, expected 1\n",
+                 mi.writeback - before.writeback);
+        failed();
+    }
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 1);
+    map_exists(&winfo, map, filelen, TRUE);
+
+    //
+    // The file holds the new page 1 and the old pages 0 and 2
+    //
+    char buf[512];
+    fd = open_file(filename, filelen);
+    for (int off = 0; off < filelen; off += sizeof(buf)) {
+        if (read(fd, buf, sizeof(buf)) != sizeof(buf)) {
+            printerr("read() at offset %d failed\n", off);
+            failed();
+        }
+        char expected = off / PGSIZE == 1 ? 'x' : val + off / PGSIZE;
+        for (int i = 0; i < sizeof(buf); i++) {
+            if (buf[i] != expected) {
+                printerr("file offset %d contains %d, expected %d\n", off + i,
+                         buf[i], expected);
+                failed();
+            }
+        }
+    }
+    close(fd);
+    printf(1, "INFO: File contents after wmsync. \tOkay.\n");
+
+    //
+    // wmsync outside any mapping fails
+    //
+    if (wmsync(MMAPBASE + filelen + PGSIZE, PGSIZE) != FAILED) {
+        printerr("wmsync() of an unmapped range succeeded\n");
+        failed();
+    }
+
+    ret = wunmap(map);
+    if (ret < 0) {
+        printerr("wunmap() returned %d\n", ret);
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: Map 1 unmapped. \tOkay.\n");
+
+    success();
+}
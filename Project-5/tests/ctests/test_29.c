@@ -0,0 +1,87 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_29
+// Summary: PCACHE: Two maps of one file share pages, and read() sees edits
+// ====================================================================
+
+char *test_name = "TEST_29";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    char *filename = "shared.txt";
+    int N_PAGES = 2;
+    char val = 30;
+    int filelen = create_big_file(filename, N_PAGES, val);
+
+    //
+    // Map the same file twice
+    //
+    int fd = open_file(filename, filelen);
+    int filebacked = MAP_FIXED | MAP_SHARED;
+    uint map1 = wmap(MMAPBASE, filelen, filebacked, fd);
+    uint map2 = wmap(MMAPBASE + PGSIZE * 16, filelen, filebacked, fd);
+    if (map1 != MMAPBASE || map2 != MMAPBASE + PGSIZE * 16) {
+        printerr("wmap() returned %d and %d\n", (int)map1, (int)map2);
+        failed();
+    }
+    close(fd);
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 2);
+    printf(1, "INFO: Maps at 0x%x and 0x%x. \tOkay.\n", map1, map2);
+
+    //
+    // Both maps load the same physical page
+    //
+    char *arr1 = (char *)map1;
+    char *arr2 = (char *)map2;
+    if (arr1[PGSIZE] != val + 1 || arr2[PGSIZE] != val + 1) {
+        printerr("second page contains %d and %d, expected %d\n", arr1[PGSIZE],
+                 arr2[PGSIZE], val + 1);
+        failed();
+    }
+    uint pa1 = get_n_validate_va2pa(map1 + PGSIZE);
+    uint pa2 = get_n_validate_va2pa(map2 + PGSIZE);
+    if (pa1 != pa2) {
+        printerr("maps use pa 0x%x and 0x%x\n", pa1, pa2);
+        failed();
+    }
+    printf(1, "INFO: Both maps use pa 0x%x. \tOkay.\n", pa1);
+
+    //
+    // An edit through one map shows in the other and in read()
+    //
+    arr1[PGSIZE + 5] = 'z';
+    if (arr2[PGSIZE + 5] != 'z') {
+        printerr("edit not visible through the second map\n");
+        failed();
+    }
+    char buf[8];
+    fd = open_file(filename, filelen);
+    char page0[512];
+    for (int off = 0; off < PGSIZE; off += sizeof(page0)) {
+        if (read(fd, page0, sizeof(page0)) != sizeof(page0)) {
+            printerr("read() failed\n");
+            failed();
+        }
+    }
+    if (read(fd, buf, sizeof(buf)) != sizeof(buf) || buf[5] != 'z' ||
+        buf[4] != val + 1) {
+        printerr("read() returned %d at offset %d, expected %d\n", buf[5],
+                 PGSIZE + 5, 'z');
+        failed();
+    }
+    close(fd);
+    printf(1, "INFO: read() sees the edit. \tOkay.\n");
+
+    if (wunmap(map1) < 0 || wunmap(map2) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: Maps unmapped. \tOkay.\n");
+
+    success();
+}
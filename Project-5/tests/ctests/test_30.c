@@ -0,0 +1,76 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_30
+// Summary: MANY MAPS: Hundreds of maps, and a map covering another fails
+// ====================================================================
+
+char *test_name = "TEST_30";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    int anon = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED;
+
+    //
+    // A map that would swallow an existing one is rejected
+    //
+    uint inner = MMAPBASE + PGSIZE * 4;
+    if (wmap(inner, PGSIZE, anon, -1) != inner) {
+        printerr("wmap() of the inner map failed\n");
+        failed();
+    }
+    uint outer = wmap(MMAPBASE, PGSIZE * 8, anon, -1);
+    if (outer != FAILED) {
+        printerr("wmap() over an existing map returned 0x%x\n", outer);
+        failed();
+    }
+    if (wunmap(inner) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    printf(1, "INFO: Covering map rejected. \tOkay.\n");
+
+    //
+    // Place many small maps, every other page
+    //
+    int N_MAPS = 200;
+    for (int i = 0; i < N_MAPS; i++) {
+        uint addr = MMAPBASE + PGSIZE * 2 * i;
+        if (wmap(addr, PGSIZE, anon, -1) != addr) {
+            printerr("wmap() of map %d failed\n", i);
+            failed();
+        }
+    }
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, N_MAPS);
+    printf(1, "INFO: %d maps placed. \tOkay.\n", N_MAPS);
+
+    //
+    // Touch each map and read it back
+    //
+    for (int i = 0; i < N_MAPS; i++) {
+        char *p = (char *)(MMAPBASE + PGSIZE * 2 * i);
+        p[0] = i % 100;
+    }
+    for (int i = 0; i < N_MAPS; i++) {
+        char *p = (char *)(MMAPBASE + PGSIZE * 2 * i);
+        if (p[0] != i % 100) {
+            printerr("map %d contains %d\n", i, p[0]);
+            failed();
+        }
+    }
+    printf(1, "INFO: All maps accessed. \tOkay.\n");
+
+    for (int i = 0; i < N_MAPS; i++) {
+        if (wunmap(MMAPBASE + PGSIZE * 2 * i) < 0) {
+            printerr("wunmap() of map %d failed\n", i);
+            failed();
+        }
+    }
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: All maps unmapped. \tOkay.\n");
+
+    success();
+}
@@ -0,0 +1,90 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_31
+// Summary: PLACEMENT: Kernel picks addresses with first-fit and best-fit
+// ====================================================================
+
+char *test_name = "TEST_31";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    int fixed = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED;
+    int firstfit = MAP_FIRSTFIT | MAP_ANONYMOUS | MAP_SHARED;
+    int bestfit = MAP_BESTFIT | MAP_ANONYMOUS | MAP_SHARED;
+
+    //
+    // Leave a 4-page gap and then a 1-page gap above MMAPBASE
+    //
+    uint fences[] = {MMAPBASE + PGSIZE * 4, MMAPBASE + PGSIZE * 6};
+    for (int i = 0; i < 2; i++) {
+        if (wmap(fences[i], PGSIZE, fixed, -1) != fences[i]) {
+            printerr("wmap() of fence %d failed\n", i);
+            failed();
+        }
+    }
+
+    //
+    // First-fit takes the lowest gap, best-fit the one-page gap
+    //
+    uint ff = wmap(0, PGSIZE, firstfit, -1);
+    if (ff != MMAPBASE) {
+        printerr("first-fit map placed at 0x%x, expected 0x%x\n", ff, MMAPBASE);
+        failed();
+    }
+    uint bf = wmap(0, PGSIZE, bestfit, -1);
+    if (bf != MMAPBASE + PGSIZE * 5) {
+        printerr("best-fit map placed at 0x%x, expected 0x%x\n", bf,
+                 MMAPBASE + PGSIZE * 5);
+        failed();
+    }
+    printf(1, "INFO: First-fit at 0x%x, best-fit at 0x%x. \tOkay.\n", ff, bf);
+
+    //
+    // A free hint is honored, a taken one is not
+    //
+    uint hint = MMAPBASE + PGSIZE * 2;
+    uint h = wmap(hint, PGSIZE, firstfit, -1);
+    if (h != hint) {
+        printerr("hinted map placed at 0x%x, expected 0x%x\n", h, hint);
+        failed();
+    }
+    uint moved = wmap(hint, PGSIZE, firstfit, -1);
+    if (moved == FAILED || moved == hint) {
+        printerr("map over a taken hint returned 0x%x\n", moved);
+        failed();
+    }
+    char *arr = (char *)moved;
+    arr[0] = 'x';
+    if (arr[0] != 'x') {
+        printerr("placed map not usable\n");
+        failed();
+    }
+    printf(1, "INFO: Hint taken, then moved to 0x%x. \tOkay.\n", moved);
+
+    //
+    // A large huge-page map starts on a 4MB boundary
+    //
+    uint hugelen = PGSIZE * 1024 * 2;
+    uint huge = wmap(0, hugelen, firstfit | MAP_HUGE, -1);
+    if (huge == FAILED || huge % (PGSIZE * 1024) != 0) {
+        printerr("huge map placed at 0x%x\n", huge);
+        failed();
+    }
+    printf(1, "INFO: Huge map at 0x%x. \tOkay.\n", huge);
+
+    uint maps[] = {fences[0], fences[1], ff, bf, h, moved, huge};
+    for (int i = 0; i < sizeof(maps) / sizeof(maps[0]); i++) {
+        if (wunmap(maps[i]) < 0) {
+            printerr("wunmap() of 0x%x failed\n", maps[i]);
+            failed();
+        }
+    }
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: Maps unmapped. \tOkay.\n");
+
+    success();
+}
@@ -0,0 +1,142 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_32
+// Summary: REMAP: Partial unmap splits a map, wremap grows, joins and moves
+// ====================================================================
+
+char *test_name = "TEST_32";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    int anon = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED;
+    uint map = MMAPBASE;
+    int N_PAGES = 4;
+    if (wmap(map, PGSIZE * N_PAGES, anon, -1) != map) {
+        printerr("wmap() failed\n");
+        failed();
+    }
+    char *arr = (char *)map;
+    for (int i = 0; i < N_PAGES; i++)
+        arr[i * PGSIZE] = 'a' + i;
+
+    //
+    // Unmapping the second page splits the map in two
+    //
+    if (wunmaprange(map + PGSIZE, PGSIZE) < 0) {
+        printerr("wunmaprange() failed\n");
+        failed();
+    }
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 2);
+    map_exists(&winfo, map, PGSIZE, TRUE);
+    map_exists(&winfo, map + PGSIZE * 2, PGSIZE * 2, TRUE);
+    if (arr[0] != 'a' || arr[PGSIZE * 2] != 'c' || arr[PGSIZE * 3] != 'd') {
+        printerr("pages lost their contents after the split\n");
+        failed();
+    }
+    printf(1, "INFO: Map split in two. \tOkay.\n");
+
+    //
+    // Growing the first part into the hole joins the parts again
+    //
+    if (wremap(map, PGSIZE, PGSIZE * 2, 0) != map) {
+        printerr("wremap() in place failed\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 1);
+    map_exists(&winfo, map, PGSIZE * N_PAGES, TRUE);
+    if (arr[PGSIZE] != 0 || arr[PGSIZE * 3] != 'd') {
+        printerr("joined map contains %d and %d\n", arr[PGSIZE], arr[PGSIZE * 3]);
+        failed();
+    }
+    printf(1, "INFO: Parts joined. \tOkay.\n");
+
+    //
+    // With a map in the way, growing needs MREMAP_MAYMOVE
+    //
+    uint fence = map + PGSIZE * N_PAGES;
+    if (wmap(fence, PGSIZE, anon, -1) != fence) {
+        printerr("wmap() of the fence failed\n");
+        failed();
+    }
+    if (wremap(map, PGSIZE * N_PAGES, PGSIZE * 8, 0) != FAILED) {
+        printerr("wremap() grew over another map\n");
+        failed();
+    }
+    uint pa = get_n_validate_va2pa(map);
+    uint moved = wremap(map, PGSIZE * N_PAGES, PGSIZE * 8, MREMAP_MAYMOVE);
+    if (moved == FAILED || moved == map) {
+        printerr("wremap() with MREMAP_MAYMOVE returned 0x%x\n", moved);
+        failed();
+    }
+    arr = (char *)moved;
+    if (arr[0] != 'a' || arr[PGSIZE * 3] != 'd') {
+        printerr("moved map lost its contents\n");
+        failed();
+    }
+    if (get_n_validate_va2pa(moved) != pa) {
+        printerr("moved page was copied\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 2);
+    map_exists(&winfo, map, PGSIZE * N_PAGES, FALSE);
+    map_exists(&winfo, moved, PGSIZE * 8, TRUE);
+    printf(1, "INFO: Map moved to 0x%x without a copy. \tOkay.\n", moved);
+
+    //
+    // Shrinking frees the pages past the new end
+    //
+    if (wremap(moved, PGSIZE * 8, PGSIZE, 0) != moved) {
+        printerr("wremap() shrink failed\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 2);
+    map_exists(&winfo, moved, PGSIZE, TRUE);
+    for (int i = 0; i < winfo.total_mmaps; i++) {
+        if (winfo.addr[i] == moved && winfo.n_loaded_pages[i] != 1) {
+            printerr("shrunk map has %d loaded pages\n", winfo.n_loaded_pages[i]);
+            failed();
+        }
+    }
+    printf(1, "INFO: Map shrunk. \tOkay.\n");
+
+    if (wunmap(moved) < 0 || wunmap(fence) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: Maps unmapped. \tOkay.\n");
+
+    //
+    // Growing a map up to another one does not join them
+    //
+    uint a = map, b = map + PGSIZE * 2;
+    if (wmap(a, PGSIZE, anon, -1) != a || wmap(b, PGSIZE, anon, -1) != b) {
+        printerr("wmap() of two neighbours failed\n");
+        failed();
+    }
+    if (wremap(a, PGSIZE, PGSIZE * 2, 0) != a) {
+        printerr("wremap() up to the neighbour failed\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 2);
+    map_exists(&winfo, a, PGSIZE * 2, TRUE);
+    map_exists(&winfo, b, PGSIZE, TRUE);
+    if (wunmap(b) < 0) {
+        printerr("wunmap() of the neighbour failed\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 1);
+    map_exists(&winfo, a, PGSIZE * 2, TRUE);
+    if (wunmap(a) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: Neighbours stay apart. \tOkay.\n");
+
+    success();
+}
@@ -0,0 +1,54 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_33
+// Summary: SWAP: A map larger than physical memory keeps its contents
+// ====================================================================
+
+char *test_name = "TEST_33";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    //
+    // Map 232MB, more than PHYSTOP (224MB)
+    //
+    int anon = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED;
+    uint map = MMAPBASE;
+    int N_PAGES = 232 * 256;
+    if (wmap(map, PGSIZE * N_PAGES, anon, -1) != map) {
+        printerr("wmap() failed\n");
+        failed();
+    }
+    printf(1, "INFO: Map placed. \tOkay.\n");
+
+    //
+    // Write every page, then read them all back, newest first so
+    // the pages still in memory are checked before they are evicted
+    //
+    for (int i = 0; i < N_PAGES; i++) {
+        int *p = (int *)(map + PGSIZE * i);
+        p[0] = i;
+        p[PGSIZE / sizeof(int) - 1] = ~i;
+    }
+    printf(1, "INFO: Wrote %d pages. \tOkay.\n", N_PAGES);
+    for (int i = N_PAGES - 1; i >= 0; i--) {
+        int *p = (int *)(map + PGSIZE * i);
+        if (p[0] != i || p[PGSIZE / sizeof(int) - 1] != ~i) {
+            printerr("page %d contains %d\n", i, p[0]);
+            failed();
+        }
+    }
+    printf(1, "INFO: Read back %d pages. \tOkay.\n", N_PAGES);
+
+    if (wunmap(map) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: Map unmapped. \tOkay.\n");
+
+    success();
+}
@@ -0,0 +1,98 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_34
+// Summary: MEMINFO: getmeminfo tracks resident pages, faults and COW
+// ====================================================================
+
+char *test_name = "TEST_34";
+
+int counter = 0;
+extern char end[];
+
+// exec loads the program on first touch; load all of it now so
+// that running the test does not change the counts
+void load_image() {
+    volatile uint start = 0;
+    for (uint a = start; a < (uint)end; a += PGSIZE)
+        (void)*(volatile char *)a;
+}
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    load_image();
+    struct meminfo before, mi;
+    get_my_meminfo(&before);
+    if (before.rss <= 0 || before.rss * PGSIZE < before.sz) {
+        printerr("rss is %d pages for size %d\n", before.rss, before.sz);
+        failed();
+    }
+    printf(1, "INFO: rss %d pages. \tOkay.\n", before.rss);
+
+    //
+    // Touching a map adds its pages and one fault per page
+    //
+    int N_PAGES = 8;
+    uint map = wmap(MMAPBASE, PGSIZE * N_PAGES, MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED, -1);
+    if (map != MMAPBASE) {
+        printerr("wmap() failed\n");
+        failed();
+    }
+    char *arr = (char *)map;
+    for (int i = 0; i < N_PAGES; i++)
+        arr[i * PGSIZE] = i;
+    get_my_meminfo(&mi);
+    if (mi.rss != before.rss + N_PAGES || mi.minflt < before.minflt + N_PAGES) {
+        printerr("rss %d and minflt %d after touching %d pages\n", mi.rss,
+                 mi.minflt, N_PAGES);
+        failed();
+    }
+    printf(1, "INFO: rss %d, minor faults %d. \tOkay.\n", mi.rss, mi.minflt);
+
+    //
+    // After fork the child shares pages copy-on-write, and writing
+    // one of them breaks the sharing
+    //
+    int pid = fork();
+    if (pid < 0) {
+        printerr("fork() failed\n");
+        failed();
+    }
+    if (pid == 0) {
+        get_my_meminfo(&mi);
+        if (mi.cow <= 0 || mi.rss != before.rss + N_PAGES) {
+            printerr("child has rss %d with %d shared\n", mi.rss, mi.cow);
+            failed();
+        }
+        counter++;
+        struct meminfo after;
+        get_my_meminfo(&after);
+        if (after.cowbreaks <= mi.cowbreaks || after.cow >= mi.cow) {
+            printerr("child cowbreaks %d, shared %d after a write\n",
+                     after.cowbreaks, after.cow);
+            failed();
+        }
+        printf(1, "INFO: Child shares %d pages, breaks %d. \tOkay.\n", mi.cow,
+               after.cowbreaks);
+        exit();
+    }
+    wait();
+
+    //
+    // Unmapping gives the pages back
+    //
+    if (wunmap(map) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    get_my_meminfo(&mi);
+    if (mi.rss != before.rss) {
+        printerr("rss %d after wunmap, expected %d\n", mi.rss, before.rss);
+        failed();
+    }
+    printf(1, "INFO: rss back to %d. \tOkay.\n", mi.rss);
+
+    success();
+}
@@ -0,0 +1,84 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_35
+// Summary: ZERO PAGE: Reads of an untouched map share one page of zeros
+// ====================================================================
+
+char *test_name = "TEST_35";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    int anon = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED;
+    uint map = MMAPBASE;
+    int N_PAGES = 64;
+    if (wmap(map, PGSIZE * N_PAGES, anon, -1) != map) {
+        printerr("wmap() failed\n");
+        failed();
+    }
+
+    //
+    // Reading every page maps the same physical page of zeros
+    //
+    char *arr = (char *)map;
+    for (int i = 0; i < N_PAGES; i++) {
+        if (arr[i * PGSIZE] != 0 || arr[i * PGSIZE + PGSIZE - 1] != 0) {
+            printerr("page %d is not zero\n", i);
+            failed();
+        }
+    }
+    uint zero = get_n_validate_va2pa(map);
+    for (int i = 1; i < N_PAGES; i++) {
+        if (get_n_validate_va2pa(map + i * PGSIZE) != zero) {
+            printerr("page %d does not map the zero page 0x%x\n", i, zero);
+            failed();
+        }
+    }
+    printf(1, "INFO: %d pages read at pa 0x%x. \tOkay.\n", N_PAGES, zero);
+
+    //
+    // A write gives the page a copy of its own
+    //
+    arr[PGSIZE * 5 + 7] = 'z';
+    uint pa = get_n_validate_va2pa(map + PGSIZE * 5);
+    if (pa == zero || arr[PGSIZE * 5] != 0 || arr[PGSIZE * 5 + 7] != 'z') {
+        printerr("written page at pa 0x%x, zero page 0x%x\n", pa, zero);
+        failed();
+    }
+    if (get_n_validate_va2pa(map + PGSIZE * 6) != zero || arr[PGSIZE * 6 + 7] != 0) {
+        printerr("write reached another page\n");
+        failed();
+    }
+    printf(1, "INFO: Written page moved to pa 0x%x. \tOkay.\n", pa);
+
+    //
+    // A page read before fork is still shared with the child
+    //
+    int pid = fork();
+    if (pid < 0) {
+        printerr("fork() failed\n");
+        failed();
+    }
+    if (pid == 0) {
+        arr[PGSIZE * 10] = 'c';
+        exit();
+    }
+    wait();
+    if (arr[PGSIZE * 10] != 'c') {
+        printerr("child's write not seen by the parent\n");
+        failed();
+    }
+    printf(1, "INFO: Child's write seen by the parent. \tOkay.\n");
+
+    if (wunmap(map) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    struct wmapinfo winfo;
+    get_n_validate_wmap_info(&winfo, 0);
+    printf(1, "INFO: Map unmapped. \tOkay.\n");
+
+    success();
+}
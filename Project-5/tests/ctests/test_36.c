@@ -0,0 +1,85 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_36
+// Summary: EXEC: Program pages load on first touch, and text is shared
+// ====================================================================
+
+char *test_name = "TEST_36";
+
+#define N_PAGES 32
+char big[PGSIZE * N_PAGES];
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        // Run again by the parent: report where main lives
+        uint pa = va2pa((uint)main);
+        write(1, &pa, sizeof(pa));
+        exit();
+    }
+
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    //
+    // bss is not loaded until it is touched
+    //
+    struct meminfo before, mi;
+    get_my_meminfo(&before);
+    if (before.rss + N_PAGES > before.sz / PGSIZE) {
+        printerr("rss is %d pages for size %d before touching bss\n",
+                 before.rss, before.sz);
+        failed();
+    }
+    int sum = 0;
+    for (int i = 0; i < N_PAGES; i++)
+        sum += big[i * PGSIZE];
+    get_my_meminfo(&mi);
+    // big may share its first page with globals already in use
+    if (sum != 0 || mi.rss < before.rss + N_PAGES - 1) {
+        printerr("rss %d after reading %d pages of bss, was %d\n", mi.rss,
+                 N_PAGES, before.rss);
+        failed();
+    }
+    printf(1, "INFO: rss %d -> %d. \tOkay.\n", before.rss, mi.rss);
+
+    //
+    // Another process running the same program maps the same text
+    //
+    int fds[2];
+    if (pipe(fds) < 0) {
+        printerr("pipe() failed\n");
+        failed();
+    }
+    int pid = fork();
+    if (pid < 0) {
+        printerr("fork() failed\n");
+        failed();
+    }
+    if (pid == 0) {
+        close(1);
+        dup(fds[1]);
+        close(fds[0]);
+        close(fds[1]);
+        char *args[] = {argv[0], "child", 0};
+        exec(argv[0], args);
+        printerr("exec() failed\n");
+        failed();
+    }
+    close(fds[1]);
+    uint child_pa = 0;
+    if (read(fds[0], &child_pa, sizeof(child_pa)) != sizeof(child_pa)) {
+        printerr("read() from the child failed\n");
+        failed();
+    }
+    close(fds[0]);
+    wait();
+    uint pa = get_n_validate_va2pa((uint)main);
+    if (child_pa != pa) {
+        printerr("main at pa 0x%x, child has it at 0x%x\n", pa, child_pa);
+        failed();
+    }
+    printf(1, "INFO: Text shared at pa 0x%x. \tOkay.\n", pa);
+
+    success();
+}
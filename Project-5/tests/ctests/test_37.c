@@ -0,0 +1,73 @@
+#include "tester.h"
+
+// ====================================================================
+// TEST_37
+// Summary: SBRK: Heap pages are only allocated, zeroed, when touched
+// ====================================================================
+
+char *test_name = "TEST_37";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    //
+    // Growing the heap only moves its end
+    //
+    int N_PAGES = 1024;
+    struct meminfo before, mi;
+    get_my_meminfo(&before);
+    char *heap = sbrk(PGSIZE * N_PAGES);
+    if (heap == (char *)-1) {
+        printerr("sbrk() failed\n");
+        failed();
+    }
+    get_my_meminfo(&mi);
+    if (mi.sz != before.sz + PGSIZE * N_PAGES || mi.rss > before.rss + 4) {
+        printerr("size %d and rss %d after sbrk, were %d and %d\n", mi.sz,
+                 mi.rss, before.sz, before.rss);
+        failed();
+    }
+    printf(1, "INFO: rss %d after growing by %d pages. \tOkay.\n", mi.rss,
+           N_PAGES);
+
+    //
+    // Touched pages read as zeros and are counted
+    //
+    int STRIDE = 16;
+    for (int i = 0; i < N_PAGES; i += STRIDE) {
+        if (heap[i * PGSIZE] != 0 || heap[i * PGSIZE + PGSIZE - 1] != 0) {
+            printerr("heap page %d is not zeroed\n", i);
+            failed();
+        }
+        heap[i * PGSIZE] = i % 100;
+    }
+    for (int i = 0; i < N_PAGES; i += STRIDE) {
+        if (heap[i * PGSIZE] != i % 100) {
+            printerr("heap page %d contains %d\n", i, heap[i * PGSIZE]);
+            failed();
+        }
+    }
+    get_my_meminfo(&mi);
+    if (mi.rss < before.rss + N_PAGES / STRIDE ||
+        mi.rss > before.rss + N_PAGES / STRIDE + 4) {
+        printerr("rss %d after touching %d pages, was %d\n", mi.rss,
+                 N_PAGES / STRIDE, before.rss);
+        failed();
+    }
+    printf(1, "INFO: rss %d after touching %d pages. \tOkay.\n", mi.rss,
+           N_PAGES / STRIDE);
+
+    //
+    // Shrinking gives them back
+    //
+    sbrk(-PGSIZE * N_PAGES);
+    get_my_meminfo(&mi);
+    if (mi.sz != before.sz || mi.rss > before.rss + 4) {
+        printerr("size %d and rss %d after shrinking\n", mi.sz, mi.rss);
+        failed();
+    }
+    printf(1, "INFO: rss back to %d. \tOkay.\n", mi.rss);
+
+    success();
+}
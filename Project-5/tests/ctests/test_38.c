@@ -0,0 +1,107 @@
+#include "tester.h"
+#include "kmemstat.h"
+
+// ====================================================================
+// TEST_38
+// Summary: SWAP: Fork shares pages in swap, and they stay shared
+// ====================================================================
+
+char *test_name = "TEST_38";
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    //
+    // Writing more pages than fit in memory sends some to swap
+    //
+    struct kmemstat st;
+    if (kmemstats(&st) < 0) {
+        printerr("kmemstats() failed\n");
+        failed();
+    }
+    int nfree = st.cached + st.zeroed;
+    for (int o = 0; o <= KMEM_MAXORDER; o++)
+        nfree += st.nfree[o] << o;
+    int N_PAGES = nfree + 512;
+    int N_CHECK = 256;
+
+    int anon = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED;
+    uint map = MMAPBASE;
+    if (wmap(map, PGSIZE * N_PAGES, anon, -1) != map) {
+        printerr("wmap() of %d pages failed\n", N_PAGES);
+        failed();
+    }
+    char *arr = (char *)map;
+    for (int i = 0; i < N_PAGES; i++)
+        arr[i * PGSIZE] = 'a' + i % 26;
+    struct meminfo mi;
+    get_my_meminfo(&mi);
+    if (mi.swapped < N_CHECK) {
+        printerr("%d pages in swap after writing %d\n", mi.swapped, N_PAGES);
+        failed();
+    }
+    printf(1, "INFO: %d of %d pages in swap. \tOkay.\n", mi.swapped, N_PAGES);
+
+    // Give back the pages written last, which are still in memory,
+    // so that fork and the faults below have room
+    int N_KEEP = N_PAGES - 1024;
+    if (wunmaprange(map + PGSIZE * N_KEEP, PGSIZE * (N_PAGES - N_KEEP)) < 0) {
+        printerr("wunmaprange() failed\n");
+        failed();
+    }
+    get_my_meminfo(&mi);
+    int swapped = mi.swapped;
+
+    //
+    // The child shares the parent's pages in swap, reads them, and
+    // writes to them
+    //
+    int pid = fork();
+    if (pid < 0) {
+        printerr("fork() with %d pages in swap failed\n", swapped);
+        failed();
+    }
+    if (pid == 0) {
+        get_my_meminfo(&mi);
+        if (mi.swapped != swapped) {
+            printerr("child has %d pages in swap, parent %d\n", mi.swapped,
+                     swapped);
+            failed();
+        }
+        for (int i = 0; i < N_CHECK; i++) {
+            if (arr[i * PGSIZE] != 'a' + i % 26) {
+                printerr("child reads %d from page %d\n", arr[i * PGSIZE], i);
+                failed();
+            }
+            arr[i * PGSIZE] = 'A' + i % 26;
+        }
+        printf(1, "INFO: Child shares %d pages in swap. \tOkay.\n", mi.swapped);
+        exit();
+    }
+    wait();
+
+    //
+    // The parent sees the child's writes
+    //
+    for (int i = 0; i < N_CHECK; i++) {
+        if (arr[i * PGSIZE] != 'A' + i % 26) {
+            printerr("parent reads %d from page %d\n", arr[i * PGSIZE], i);
+            failed();
+        }
+    }
+    printf(1, "INFO: Parent sees the child's writes. \tOkay.\n");
+
+    if (wunmap(map) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    get_my_meminfo(&mi);
+    if (mi.swapped != 0) {
+        printerr("%d pages in swap after wunmap\n", mi.swapped);
+        failed();
+    }
+    printf(1, "INFO: Swap emptied. \tOkay.\n");
+
+    success();
+}
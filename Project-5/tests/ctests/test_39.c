@@ -0,0 +1,126 @@
+#include "tester.h"
+#include "kmemstat.h"
+
+// ====================================================================
+// TEST_39
+// Summary: ZERO PAGE: Fork does not allocate pages for zero-page maps
+// ====================================================================
+
+char *test_name = "TEST_39";
+
+int free_pages() {
+    struct kmemstat st;
+    if (kmemstats(&st) < 0) {
+        printerr("kmemstats() failed\n");
+        failed();
+    }
+    int n = st.cached + st.zeroed;
+    for (int o = 0; o <= KMEM_MAXORDER; o++)
+        n += st.nfree[o] << o;
+    return n;
+}
+
+int main() {
+    printf(1, "\n\n%s\n", test_name);
+    validate_initial_state();
+
+    int anon = MAP_FIXED | MAP_ANONYMOUS | MAP_SHARED;
+    uint map = MMAPBASE;
+    int N_PAGES = 1024;
+    struct meminfo before, mi;
+    get_my_meminfo(&before);
+    if (wmap(map, PGSIZE * N_PAGES, anon, -1) != map) {
+        printerr("wmap() failed\n");
+        failed();
+    }
+
+    //
+    // Every page is read, so maps the zero page
+    //
+    char *arr = (char *)map;
+    for (int i = 0; i < N_PAGES; i++) {
+        if (arr[i * PGSIZE] != 0) {
+            printerr("page %d is not zero\n", i);
+            failed();
+        }
+    }
+    uint zero = get_n_validate_va2pa(map);
+    if (get_n_validate_va2pa(map + PGSIZE * (N_PAGES - 1)) != zero) {
+        printerr("pages do not share the zero page 0x%x\n", zero);
+        failed();
+    }
+    get_my_meminfo(&mi);
+    if (mi.rss != before.rss + N_PAGES) {
+        printerr("rss %d after reading %d pages, was %d\n", mi.rss, N_PAGES,
+                 before.rss);
+        failed();
+    }
+    printf(1, "INFO: %d pages map the zero page. \tOkay.\n", N_PAGES);
+
+    //
+    // Fork gives neither process a page for them
+    //
+    int nfree = free_pages();
+    int pid = fork();
+    if (pid < 0) {
+        printerr("fork() failed\n");
+        failed();
+    }
+    if (pid == 0) {
+        get_my_meminfo(&mi);
+        if (mi.rss > before.rss + 4) {
+            printerr("child rss %d, parent's was %d before wmap\n", mi.rss,
+                     before.rss);
+            failed();
+        }
+        if (free_pages() < nfree - N_PAGES / 4) {
+            printerr("%d free pages after fork, %d before\n", free_pages(),
+                     nfree);
+            failed();
+        }
+        printf(1, "INFO: Child rss %d. \tOkay.\n", mi.rss);
+
+        // Writes to the even pages reach the parent
+        for (int i = 0; i < N_PAGES; i += 2) {
+            if (arr[i * PGSIZE] != 0) {
+                printerr("child reads %d from page %d\n", arr[i * PGSIZE], i);
+                failed();
+            }
+            arr[i * PGSIZE] = 'a' + i % 26;
+        }
+        exit();
+    }
+    get_my_meminfo(&mi);
+    if (mi.rss > before.rss + 4) {
+        printerr("parent rss %d after fork, was %d before wmap\n", mi.rss,
+                 before.rss);
+        failed();
+    }
+    wait();
+
+    //
+    // The parent sees the child's writes, and zeros elsewhere
+    //
+    for (int i = 0; i < N_PAGES; i++) {
+        char want = i % 2 == 0 ? 'a' + i % 26 : 0;
+        if (arr[i * PGSIZE] != want) {
+            printerr("parent reads %d from page %d, expected %d\n",
+                     arr[i * PGSIZE], i, want);
+            failed();
+        }
+    }
+    printf(1, "INFO: Parent sees the child's writes. \tOkay.\n");
+
+    if (wunmap(map) < 0) {
+        printerr("wunmap() failed\n");
+        failed();
+    }
+    get_my_meminfo(&mi);
+    if (mi.rss != before.rss) {
+        printerr("rss %d after wunmap, expected %d\n", mi.rss, before.rss);
+        failed();
+    }
+    printf(1, "INFO: rss back to %d. \tOkay.\n", mi.rss);
+
+    success();
+}
@@ -8,6 +8,8 @@
 #include "stat.h"
 
 #include "wmap.h"
+#include "param.h"
+#include "meminfo.h"
 
 // Test Helpers
 #define MMAPBASE 0x60000000
@@ -108,6 +110,18 @@ uint get_n_validate_va2pa(uint va) {
     return pa;
 }
 
+/**
+ * Fill in the memory counters of the calling process
+ */
+void get_my_meminfo(struct meminfo *mi) {
+    for (int i = 0; i < NPROC; i++) {
+        if (getmeminfo(i, mi) == 0 && mi->pid == getpid())
+            return;
+    }
+    printerr("getmeminfo() found no slot for pid %d\n", getpid());
+    failed();
+}
+
 void map_allocated(struct wmapinfo *info, uint addr, int length,
                    int n_loaded_pages) {
     int found = 0;
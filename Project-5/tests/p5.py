@@ -279,6 +279,160 @@ class test25(Xv6Test):
     failure_pattern = "Segmentation Fault"
 
 
+class test26(Xv6Test):
+    name = "test_26"
+    description = "HUGE: 4MB-aligned anonymous map is backed by 4MB pages"
+    tester = "ctests/test_26.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test27(Xv6Test):
+    name = "test_27"
+    description = "READAHEAD: Sequential scan of a filebacked map takes fewer faults"
+    tester = "ctests/test_27.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test28(Xv6Test):
+    name = "test_28"
+    description = "WMSYNC: Modified page is written back without unmapping"
+    tester = "ctests/test_28.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test29(Xv6Test):
+    name = "test_29"
+    description = "PCACHE: Two maps of one file share pages, and read() sees edits"
+    tester = "ctests/test_29.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test30(Xv6Test):
+    name = "test_30"
+    description = "MANY MAPS: Hundreds of maps, and a map covering another fails"
+    tester = "ctests/test_30.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test31(Xv6Test):
+    name = "test_31"
+    description = "PLACEMENT: Kernel picks addresses with first-fit and best-fit"
+    tester = "ctests/test_31.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test32(Xv6Test):
+    name = "test_32"
+    description = "REMAP: Partial unmap splits a map, wremap grows, joins and moves"
+    tester = "ctests/test_32.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test33(Xv6Test):
+    name = "test_33"
+    description = "SWAP: A map larger than physical memory keeps its contents"
+    tester = "ctests/test_33.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test34(Xv6Test):
+    name = "test_34"
+    description = "MEMINFO: getmeminfo tracks resident pages, faults and COW"
+    tester = "ctests/test_34.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test35(Xv6Test):
+    name = "test_35"
+    description = "ZERO PAGE: Reads of an untouched map share one page of zeros"
+    tester = "ctests/test_35.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test36(Xv6Test):
+    name = "test_36"
+    description = "EXEC: Program pages load on first touch, and text is shared"
+    tester = "ctests/test_36.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test37(Xv6Test):
+    name = "test_37"
+    description = "SBRK: Heap pages are only allocated, zeroed, when touched"
+    tester = "ctests/test_37.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test38(Xv6Test):
+    name = "test_38"
+    description = "SWAP: Fork shares pages in swap, and they stay shared"
+    tester = "ctests/test_38.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
+class test39(Xv6Test):
+    name = "test_39"
+    description = "ZERO PAGE: Fork does not allocate pages for zero-page maps"
+    tester = "ctests/test_39.c"
+    header = "ctests/tester.h"
+    make_qemu_args = "CPUS=1"
+    point_value = 1
+    success_pattern = "PASSED"
+    failure_pattern = "Segmentation Fault"
+
+
 from testing.runtests import main
 
 main(
@@ -309,6 +463,20 @@ main(
         test23,
         test24,
         test25,
+        test26,
+        test27,
+        test28,
+        test29,
+        test30,
+        test31,
+        test32,
+        test33,
+        test34,
+        test35,
+        test36,
+        test37,
+        test38,
+        test39,
     ],
     # Add your test groups here
     # End of test groups
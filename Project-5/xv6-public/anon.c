@@ -0,0 +1,166 @@
+// Pages of anonymous wmap regions shared by fork.
+//
+// Pages a region has at fork stay shared through the page tables,
+// but a page first touched after fork is faulted in by each process
+// on its own. To give every sharer the same page, fork attaches an
+// anon to each anonymous region, and the region's pages are then
+// looked up here by anon and offset within the region.
+//
+// Interface:
+// * fork calls anonalloc for a region that has no anon yet, and
+//   anondup for the child's copy. Splitting a region dups it too,
+//   and removing one calls anonput.
+// * The fault path calls anonget, which returns the page for an
+//   offset with a reference the caller owns, a new zeroed one if no
+//   sharer has touched it yet.
+//
+// The table holds one kalloc reference to each page until every
+// region holding the anon maps it, since until then a sharer may
+// still fault it in. Each PTE that maps the page holds another. If
+// the table is full, a new page stays private to the process that
+// faulted it in.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "spinlock.h"
+
+#define NANON 64
+#define NAPAGE 1024
+
+struct anon {
+  int ref;             // Regions holding it, 0 if free
+};
+
+struct apage {
+  struct anon *a;      // 0 if the slot is free
+  uint off;            // Page-aligned offset in the region
+  char *page;
+};
+
+struct {
+  struct spinlock lock;
+  struct anon anons[NANON];
+  struct apage pages[NAPAGE];
+} anontab;
+
+void
+anoninit(void)
+{
+  initlock(&anontab.lock, "anon");
+}
+
+// Return a new anon for one region, or 0 if none is free.
+struct anon*
+anonalloc(void)
+{
+  struct anon *a;
+
+  acquire(&anontab.lock);
+  for(a = anontab.anons; a < &anontab.anons[NANON]; a++){
+    if(a->ref == 0){
+      a->ref = 1;
+      release(&anontab.lock);
+      return a;
+    }
+  }
+  release(&anontab.lock);
+  return 0;
+}
+
+// Take a reference to a for another region.
+struct anon*
+anondup(struct anon *a)
+{
+  acquire(&anontab.lock);
+  a->ref++;
+  release(&anontab.lock);
+  return a;
+}
+
+// Drop a region's reference to a. With the last one go the pages
+// no sharer had faulted in; mapped ones stay with their mappings.
+void
+anonput(struct anon *a)
+{
+  struct apage *ap;
+
+  acquire(&anontab.lock);
+  if(a->ref < 1)
+    panic("anonput");
+  if(--a->ref == 0){
+    for(ap = anontab.pages; ap < &anontab.pages[NAPAGE]; ap++){
+      if(ap->a == a){
+        kfree(ap->page);
+        ap->a = 0;
+        ap->page = 0;
+      }
+    }
+  }
+  release(&anontab.lock);
+}
+
+// Return 1 if table entry ap is no longer needed: every region
+// holding its anon maps the page. anontab.lock must be held.
+static int
+apagedone(struct apage *ap)
+{
+  return get_refcount(V2P(ap->page)) - 1 >= ap->a->ref;
+}
+
+// Return the page of a at page-aligned offset off, with a reference
+// for the caller. A page no sharer has touched yet is allocated
+// zeroed. Returns 0 if out of memory.
+char*
+anonget(struct anon *a, uint off)
+{
+  struct apage *ap, *victim;
+  char *mem, *page;
+
+  acquire(&anontab.lock);
+  for(ap = anontab.pages; ap < &anontab.pages[NAPAGE]; ap++){
+    if(ap->a == a && ap->off == off){
+      page = ap->page;
+      incref(V2P(page));
+      if(apagedone(ap)){
+        kfree(page);  // Drop the table's reference
+        ap->a = 0;
+        ap->page = 0;
+      }
+      release(&anontab.lock);
+      return page;
+    }
+  }
+  release(&anontab.lock);
+
+  if((mem = kzalloc()) == 0)
+    return 0;
+
+  // The table lock was dropped, so another sharer may have added
+  // the page meanwhile.
+  acquire(&anontab.lock);
+  victim = 0;
+  for(ap = anontab.pages; ap < &anontab.pages[NAPAGE]; ap++){
+    if(ap->a == a && ap->off == off){
+      page = ap->page;
+      incref(V2P(page));
+      release(&anontab.lock);
+      kfree(mem);
+      return page;
+    }
+    if(victim == 0 && (ap->a == 0 || apagedone(ap)))
+      victim = ap;
+  }
+  if(a->ref > 1 && victim){
+    if(victim->a)
+      kfree(victim->page);
+    victim->a = a;
+    victim->off = off;
+    victim->page = mem;
+    incref(V2P(mem));
+  }
+  release(&anontab.lock);
+  return mem;
+}
@@ -1,10 +1,13 @@
 #include "types.h"
 #include "mmu.h"   // Add this at the top for pte_t definition
 
+struct anon;
 struct buf;
 struct context;
 struct file;
 struct inode;
+struct kmemstat;
+struct meminfo;
 struct pipe;
 struct proc;
 struct rtcdate;
@@ -12,6 +15,14 @@ struct spinlock;
 struct sleeplock;
 struct stat;
 struct superblock;
+struct vm_area;
+
+// anon.c
+void            anoninit(void);
+struct anon*    anonalloc(void);
+struct anon*    anondup(struct anon*);
+void            anonput(struct anon*);
+char*           anonget(struct anon*, uint);
 
 // bio.c
 void            binit(void);
@@ -71,9 +82,13 @@ void            kinit1(void*, void*);
 void            kinit2(void*, void*);
 char*           kalloc(void);
 void            kfree(char*);
+char*           kalloc_order(int);
+char*           kzalloc(void);
+void            kzerofill(void);
+void            kfree_order(char*, int);
+void            kmemstats(struct kmemstat*);
 void            incref(uint pa);
-void            decref(uint pa);
-uchar           get_refcount(uint pa);
+int             get_refcount(uint pa);
 
 // kbd.c
 void            kbdintr(void);
@@ -101,6 +116,15 @@ void            mpinit(void);
 void            picenable(int);
 void            picinit(void);
 
+// pcache.c
+void            pcacheinit(void);
+char*           pcget(struct inode*, uint);
+char*           pcpeek(struct inode*, uint);
+int             pcread(struct inode*, char*, uint, uint);
+void            pcwrite(struct inode*, char*, uint, uint);
+void            pcinval(struct inode*);
+int             pcshrink(void);
+
 // pipe.c
 int             pipealloc(struct file**, struct file**);
 void            pipeclose(struct pipe*, int);
@@ -118,6 +142,7 @@ struct cpu*     mycpu(void);
 struct proc*    myproc();
 void            pinit(void);
 void            procdump(void);
+int             procmeminfo(int, struct meminfo*);
 void            scheduler(void) __attribute__((noreturn));
 void            sched(void);
 void            setproc(struct proc*);
@@ -130,6 +155,13 @@ void            yield(void);
 // swtch.S
 void            swtch(struct context**, struct context*);
 
+// swap.c
+void            swapinit(void);
+int             swapin(struct proc*, pte_t*);
+void            swapdup(pte_t);
+void            swapfree(pte_t);
+int             reclaim(void);
+
 // spinlock.c
 void            acquire(struct spinlock*);
 void            getcallerpcs(void*, uint*);
@@ -193,6 +225,24 @@ int             copyout(pde_t*, uint, void*, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
 pte_t*          walkpgdir(pde_t* pgdir, const void* va, int alloc);
 int             mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm);
+int             ptunshare(pde_t*, const void*);
+int             cowcopy(pde_t*, pte_t*);
+int             pagefault(uint, uint);
+int             uvmprefault(uint, uint, int);
+int             wmwriteback(struct vm_area*, uint, uint);
+int             wmfree(struct vm_area*, uint, uint);
+int             wmmove(pde_t*, uint, uint, uint);
+
+// vma.c
+struct vm_area* vmafind(struct proc*, uint);
+struct vm_area* vmaoverlap(struct proc*, uint, uint);
+struct vm_area* vmainsert(struct proc*, uint, uint);
+uint            vmaplace(struct proc*, uint, uint, int);
+void            vmaremove(struct proc*, struct vm_area*);
+int             vmaunmap(struct proc*, uint, uint);
+void            vmamerge(struct proc*, struct vm_area*);
+int             vmacopy(struct proc*, struct proc*);
+void            vmafree(struct proc*);
 
 // number of elements in fixed-size array
 #define NELEM(x) (sizeof(x)/sizeof((x)[0]))
\ No newline at end of file
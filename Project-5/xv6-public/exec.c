@@ -12,10 +12,11 @@ exec(char *path, char **argv)
 {
   char *s, *last;
   int i, off;
-  uint argc, sz, sp, ustack[3+MAXARG+1];
+  uint argc, sz, sp, npages, nseg, ustack[3+MAXARG+1];
   struct elfhdr elf;
-  struct inode *ip;
+  struct inode *ip, *exe, *oldexe;
   struct proghdr ph;
+  struct segment segs[NSEG], *seg;
   pde_t *pgdir, *oldpgdir;
   struct proc *curproc = myproc();
 
@@ -28,6 +29,7 @@ exec(char *path, char **argv)
   }
   ilock(ip);
   pgdir = 0;
+  exe = 0;
 
   // Check ELF header
   if(readi(ip, (char*)&elf, 0, sizeof(elf)) != sizeof(elf))
@@ -38,8 +40,13 @@ exec(char *path, char **argv)
   if((pgdir = setupkvm()) == 0)
     goto bad;
 
-  // Load program into memory.
+  // Load program into memory. Segments are only recorded, to be
+  // paged in from the file when first touched (see pagefault);
+  // those past NSEG or whose file offset is not page aligned, as
+  // with ld -N, are read in now.
   sz = 0;
+  npages = 0;
+  nseg = 0;
   for(i=0, off=elf.phoff; i<elf.phnum; i++, off+=sizeof(ph)){
     if(readi(ip, (char*)&ph, off, sizeof(ph)) != sizeof(ph))
       goto bad;
@@ -49,15 +56,28 @@ exec(char *path, char **argv)
       goto bad;
     if(ph.vaddr + ph.memsz < ph.vaddr)
       goto bad;
-    if((sz = allocuvm(pgdir, sz, ph.vaddr + ph.memsz)) == 0)
-      goto bad;
     if(ph.vaddr % PGSIZE != 0)
       goto bad;
-    if(loaduvm(pgdir, (char*)ph.vaddr, ip, ph.off, ph.filesz) < 0)
-      goto bad;
+    if(ph.off % PGSIZE == 0 && nseg < NSEG){
+      seg = &segs[nseg++];
+      seg->va = ph.vaddr;
+      seg->memsz = ph.memsz;
+      seg->filesz = ph.filesz;
+      seg->off = ph.off;
+      seg->writable = (ph.flags & ELF_PROG_FLAG_WRITE) != 0;
+    } else {
+      if(allocuvm(pgdir, ph.vaddr, ph.vaddr + ph.memsz) == 0)
+        goto bad;
+      npages += PGROUNDUP(ph.memsz) / PGSIZE;
+      if(loaduvm(pgdir, (char*)ph.vaddr, ip, ph.off, ph.filesz) < 0)
+        goto bad;
+    }
+    if(ph.vaddr + ph.memsz > sz)
+      sz = ph.vaddr + ph.memsz;
   }
-  iunlockput(ip);
+  iunlock(ip);
   end_op();
+  exe = ip;  // Keep the reference for paging in
   ip = 0;
 
   // Allocate two pages at the next page boundary.
@@ -99,8 +119,21 @@ exec(char *path, char **argv)
   curproc->sz = sz;
   curproc->tf->eip = elf.entry;  // main
   curproc->tf->esp = sp;
+  oldexe = curproc->exe;
+  curproc->exe = exe;
+  curproc->nseg = nseg;
+  memmove(curproc->segs, segs, sizeof(segs));
   switchuvm(curproc);
+  curproc->nswap = 0;  // freevm releases the swap slots
+  curproc->rss = npages + 2;  // And the stack and its guard page
+  curproc->ncow = 0;
+  curproc->nzero = 0;
   freevm(oldpgdir);
+  if(oldexe){
+    begin_op();
+    iput(oldexe);
+    end_op();
+  }
   return 0;
 
  bad:
@@ -110,5 +143,10 @@ exec(char *path, char **argv)
     iunlockput(ip);
     end_op();
   }
+  if(exe){
+    begin_op();
+    iput(exe);
+    end_op();
+  }
   return -1;
 }
@@ -14,6 +14,7 @@ struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
+  int npcache;        // Pages in the page cache, protected by its lock
   struct sleeplock lock; // protects everything below here
   int valid;          // inode has been read from disk?
 
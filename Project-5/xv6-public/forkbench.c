@@ -0,0 +1,77 @@
+// Fork latency benchmark. Grows the heap and maps a number of wmap
+// regions, each in its own 4MB page-table range, touches every page,
+// and then times forks whose children exit at once, and forks whose
+// children write one byte to each heap page first.
+//
+// usage: forkbench [heap pages] [wmap regions] [forks]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE 4096
+#define PTSPAN (1024 * PGSIZE)
+#define MAPBASE 0x60000000
+#define MAXREGIONS 16
+
+int
+timeforks(int n, char *heap, int pages, int touch)
+{
+  int i, j, pid, start;
+
+  start = uptime();
+  for(i = 0; i < n; i++){
+    pid = fork();
+    if(pid < 0){
+      printf(2, "forkbench: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      if(touch)
+        for(j = 0; j < pages; j++)
+          heap[j * PGSIZE] = j;
+      exit();
+    }
+    wait();
+  }
+  return uptime() - start;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, pages, regions, n, t;
+  char *heap, *map;
+
+  pages = argc > 1 ? atoi(argv[1]) : 1024;
+  regions = argc > 2 ? atoi(argv[2]) : 8;
+  n = argc > 3 ? atoi(argv[3]) : 100;
+  if(pages < 1 || regions < 0 || regions > MAXREGIONS || n < 1){
+    printf(2, "usage: forkbench [heap pages] [wmap regions] [forks]\n");
+    exit();
+  }
+
+  heap = sbrk(pages * PGSIZE);
+  if(heap == (char*)-1){
+    printf(2, "forkbench: sbrk failed\n");
+    exit();
+  }
+  for(i = 0; i < pages; i++)
+    heap[i * PGSIZE] = i;
+  for(i = 0; i < regions; i++){
+    map = (char*)wmap(MAPBASE + i * PTSPAN, PGSIZE,
+                      MAP_FIXED | MAP_SHARED | MAP_ANONYMOUS, -1);
+    if(map == (char*)FAILED){
+      printf(2, "forkbench: wmap failed\n");
+      exit();
+    }
+    map[0] = i;
+  }
+
+  printf(1, "forkbench: %d heap pages, %d wmap regions\n", pages, regions);
+  t = timeforks(n, heap, pages, 0);
+  printf(1, "forkbench: fork+exit %d forks in %d ticks\n", n, t);
+  t = timeforks(n, heap, pages, 1);
+  printf(1, "forkbench: fork+write+exit %d forks in %d ticks\n", n, t);
+  exit();
+}
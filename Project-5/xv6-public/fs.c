@@ -344,6 +344,13 @@ iput(struct inode *ip)
       ip->valid = 0;
     }
   }
+  if(ip->npcache){
+    acquire(&icache.lock);
+    int r = ip->ref;
+    release(&icache.lock);
+    if(r == 1)
+      pcinval(ip);  // Last reference: the cache keys on this inode
+  }
   releasesleep(&ip->lock);
 
   acquire(&icache.lock);
@@ -467,8 +474,10 @@ readi(struct inode *ip, char *dst, uint off, uint n)
     n = ip->size - off;
 
   for(tot=0; tot<n; tot+=m, off+=m, dst+=m){
-    bp = bread(ip->dev, bmap(ip, off/BSIZE));
     m = min(n - tot, BSIZE - off%BSIZE);
+    if(ip->npcache && pcread(ip, dst, off, m))
+      continue;  // The page is mapped somewhere and may be newer
+    bp = bread(ip->dev, bmap(ip, off/BSIZE));
     memmove(dst, bp->data + off%BSIZE, m);
     brelse(bp);
   }
@@ -501,6 +510,8 @@ writei(struct inode *ip, char *src, uint off, uint n)
     memmove(bp->data + off%BSIZE, src, m);
     log_write(bp);
     brelse(bp);
+    if(ip->npcache)
+      pcwrite(ip, src, off, m);
   }
 
   if(n > 0 && off > ip->size){
@@ -1,6 +1,21 @@
 // Physical memory allocator, intended to allocate
 // memory for user processes, kernel stacks, page table pages,
-// and pipe buffers. Allocates 4096-byte pages.
+// and pipe buffers. Allocates 4096-byte pages, or physically
+// contiguous blocks of 2^n pages through kalloc_order().
+//
+// Free memory is kept by a binary buddy allocator: a free block
+// of order n is 2^n pages aligned to its own size, and when both
+// halves of a block are free they are merged back into it.
+// Single pages are handed out through per-CPU caches that are
+// refilled from, and drained back to, the buddy allocator.
+//
+// Allocated pages (or the first page of an allocated block) carry
+// a reference count, so pages shared copy-on-write between address
+// spaces are only freed when the last one lets go of them.
+//
+// CPUs with nothing to run zero free pages ahead of time, a batch
+// at a time, so that kzalloc() can hand them out without clearing
+// them when a process faults in fresh memory.
 
 #include "types.h"
 #include "defs.h"
@@ -8,6 +23,20 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "spinlock.h"
+#include "x86.h"
+#include "kmemstat.h"
+
+// Pages move between a CPU's cache and the shared pool in batches
+// of KBATCH, so the pool lock is taken once per KBATCH operations.
+#define KBATCHORDER 5
+#define KBATCH (1 << KBATCHORDER)
+#define KCACHEMAX (2*KBATCH)
+
+#define NZEROED 128              // Most pages kept zeroed ahead of time
+#define ZBATCH 8                 // Pages an idle CPU zeroes at a time
+
+#define NPAGE (PHYSTOP / PGSIZE)
+#define PG_FREE 0x80           // Page heads a free block; low bits are its order
 
 void freerange(void *vstart, void *vend);
 extern char end[]; // first address after kernel loaded from ELF file
@@ -15,14 +44,44 @@ extern char end[]; // first address after kernel loaded from ELF file
 
 struct run {
   struct run *next;
+  struct run *prev;            // Only used on the buddy free lists
+};
+
+// Per-CPU cache of free pages. Only its own CPU uses it, with
+// interrupts off, so its lock is only ever contended by another
+// CPU that ran dry and is stealing pages.
+struct kcache {
+  struct spinlock lock;
+  struct run *freelist;
+  int nfree;
+  uint nalloc;                 // Pages handed out from this CPU
+  uint latency[KMEM_NLAT];     // Allocation latency histogram
 };
 
 struct {
   struct spinlock lock;
   int use_lock;
-  struct run *freelist;
+  struct run freelist[KMEM_MAXORDER+1];  // Circular lists of free blocks
+  int nfree[KMEM_MAXORDER+1];
+  uchar page[NPAGE];           // PG_FREE|order for free block heads
+  uint ref[NPAGE];             // References to allocated pages; the zero
+                               // page can have one per wmap page
+  uint nalloc[KMEM_MAXORDER+1];
+  uint nfail[KMEM_MAXORDER+1];
+  uint blocklatency[KMEM_NLAT];  // Latency histogram for order > 0
+  struct kcache cache[NCPU];
 } kmem;
 
+// Pages zeroed by idle CPUs. The buddy allocator counts them as
+// handed out, though they have no references; kalloc() takes them
+// back when it finds no other free page, and kalloc_order() returns
+// them all to the buddy lists when no block is large enough.
+struct {
+  struct spinlock lock;
+  struct run *freelist;
+  int nfree;
+} kzero;
+
 // Initialization happens in two phases.
 // 1. main() calls kinit1() while still using entrypgdir to place just
 // the pages mapped by entrypgdir on free list.
@@ -31,7 +90,14 @@ struct {
 void
 kinit1(void *vstart, void *vend)
 {
+  int i;
+
   initlock(&kmem.lock, "kmem");
+  for(i = 0; i <= KMEM_MAXORDER; i++)
+    kmem.freelist[i].next = kmem.freelist[i].prev = &kmem.freelist[i];
+  for(i = 0; i < NCPU; i++)
+    initlock(&kmem.cache[i].lock, "kcache");
+  initlock(&kzero.lock, "kzero");
   kmem.use_lock = 0;
   freerange(vstart, vend);
 }
@@ -51,6 +117,157 @@ freerange(void *vstart, void *vend)
   for(; p + PGSIZE <= (char*)vend; p += PGSIZE)
     kfree(p);
 }
+
+// Count an allocation that took the given number of cycles in
+// the histogram: bucket i holds latencies below 2^(i+KMEM_LATSHIFT+1).
+static void
+addlatency(uint *hist, uint cycles)
+{
+  int i;
+
+  cycles >>= KMEM_LATSHIFT;
+  for(i = 0; cycles > 1 && i < KMEM_NLAT - 1; i++)
+    cycles >>= 1;
+  hist[i]++;
+}
+
+// Put the free block at v of the given order on its list.
+// kmem.lock must be held.
+static void
+buddyinsert(char *v, int order)
+{
+  struct run *r = (struct run*)v;
+  struct run *head = &kmem.freelist[order];
+
+  r->next = head->next;
+  r->prev = head;
+  head->next->prev = r;
+  head->next = r;
+  kmem.nfree[order]++;
+  kmem.page[V2P(v) / PGSIZE] = PG_FREE | order;
+}
+
+// Take the free block at v of the given order off its list.
+// kmem.lock must be held.
+static void
+buddyremove(char *v, int order)
+{
+  struct run *r = (struct run*)v;
+
+  r->prev->next = r->next;
+  r->next->prev = r->prev;
+  kmem.nfree[order]--;
+  kmem.page[V2P(v) / PGSIZE] = 0;
+}
+
+// Free a block of 2^order pages, merging it with its buddy for as
+// long as the buddy is free as a whole. kmem.lock must be held.
+static void
+buddyfree(char *v, int order)
+{
+  uint pa = V2P(v), buddy;
+
+  while(order < KMEM_MAXORDER){
+    buddy = pa ^ (PGSIZE << order);
+    if(buddy >= PHYSTOP || kmem.page[buddy / PGSIZE] != (PG_FREE | order))
+      break;
+    buddyremove(P2V(buddy), order);
+    if(buddy < pa)
+      pa = buddy;
+    order++;
+  }
+  buddyinsert(P2V(pa), order);
+}
+
+// Allocate a block of 2^order pages, splitting a larger block if
+// there is no free block of that order. kmem.lock must be held.
+static char*
+buddyalloc(int order)
+{
+  char *v;
+  int k;
+
+  for(k = order; k <= KMEM_MAXORDER; k++)
+    if(kmem.nfree[k])
+      break;
+  if(k > KMEM_MAXORDER)
+    return 0;
+
+  v = (char*)kmem.freelist[k].next;
+  buddyremove(v, k);
+  // Give back the upper half at each level on the way down
+  while(k > order){
+    k--;
+    buddyinsert(v + (PGSIZE << k), k);
+  }
+  return v;
+}
+
+// Detach up to n pages from the front of *list and return them
+// as a null-terminated chain. *got is set to the number detached.
+static struct run*
+takepages(struct run **list, int n, int *got)
+{
+  struct run *head, *r;
+  int i;
+
+  head = *list;
+  if(head == 0){
+    *got = 0;
+    return 0;
+  }
+  for(i = 1, r = head; i < n && r->next; i++)
+    r = r->next;
+  *list = r->next;
+  r->next = 0;
+  *got = i;
+  return head;
+}
+
+// Prepend the null-terminated chain of pages to *list.
+static void
+putpages(struct run **list, struct run *chain)
+{
+  struct run *r;
+
+  if(chain == 0)
+    return;
+  for(r = chain; r->next; r = r->next)
+    ;
+  r->next = *list;
+  *list = chain;
+}
+
+// Drop a reference to the allocated page at pa and return how
+// many are left. Pages that were never handed out count as having
+// a single reference, so freerange() can free them.
+static int
+dropref(uint pa)
+{
+  uint *ref = &kmem.ref[pa / PGSIZE];
+
+  if(*ref > 1)
+    return __sync_sub_and_fetch(ref, 1);
+  *ref = 0;
+  return 0;
+}
+
+// Take another reference to the allocated page at pa.
+void
+incref(uint pa)
+{
+  if(pa >= PHYSTOP || kmem.ref[pa / PGSIZE] == 0)
+    panic("incref");
+  __sync_fetch_and_add(&kmem.ref[pa / PGSIZE], 1);
+}
+
+// Number of references to the allocated page at pa.
+int
+get_refcount(uint pa)
+{
+  return kmem.ref[pa / PGSIZE];
+}
+
 //PAGEBREAK: 21
 // Free the page of physical memory pointed at by v,
 // which normally should have been returned by a
@@ -59,21 +276,137 @@ freerange(void *vstart, void *vend)
 void
 kfree(char *v)
 {
-  struct run *r;
+  struct run *r, *spill = 0;
+  struct kcache *c;
+  int n;
 
   if((uint)v % PGSIZE || v < end || V2P(v) >= PHYSTOP)
     panic("kfree");
+  if(dropref(V2P(v)) > 0)
+    return;
 
   // Fill with junk to catch dangling refs.
   memset(v, 1, PGSIZE);
+  r = (struct run*)v;
 
-  if(kmem.use_lock)
+  // Before the other CPUs run, pages go straight to the buddy lists.
+  if(!kmem.use_lock){
+    buddyfree(v, 0);
+    return;
+  }
+
+  pushcli();
+  c = &kmem.cache[cpuid()];
+  acquire(&c->lock);
+  r->next = c->freelist;
+  c->freelist = r;
+  // Keep the cache bounded by handing a batch back to the pool.
+  if(++c->nfree > KCACHEMAX){
+    spill = takepages(&c->freelist, KBATCH, &n);
+    c->nfree -= n;
+  }
+  release(&c->lock);
+
+  if(spill){
     acquire(&kmem.lock);
-  r = (struct run*)v;
-  r->next = kmem.freelist;
-  kmem.freelist = r;
-  if(kmem.use_lock)
+    while(spill){
+      r = spill;
+      spill = r->next;
+      buddyfree((char*)r, 0);
+    }
     release(&kmem.lock);
+  }
+  popcli();
+}
+
+// Take pages for cache c, which is empty: a batch from the buddy
+// allocator or, if it is out of pages, half of another CPU's cache.
+// Returns one page and puts the rest in c. Interrupts must be off.
+static struct run*
+refill(struct kcache *c)
+{
+  struct kcache *v;
+  struct run *chain = 0, *r;
+  char *block;
+  int i, n = 0;
+
+  acquire(&kmem.lock);
+  // One split block is cheaper than KBATCH single pages, but do not
+  // break up large blocks when single pages are still around.
+  if(kmem.nfree[0] < KBATCH && (block = buddyalloc(KBATCHORDER)) != 0){
+    for(i = KBATCH - 1; i >= 0; i--){
+      r = (struct run*)(block + i*PGSIZE);
+      r->next = chain;
+      chain = r;
+    }
+    n = KBATCH;
+  } else {
+    for(; n < KBATCH && (block = buddyalloc(0)) != 0; n++){
+      r = (struct run*)block;
+      r->next = chain;
+      chain = r;
+    }
+  }
+  release(&kmem.lock);
+
+  for(v = kmem.cache; chain == 0 && v < &kmem.cache[NCPU]; v++){
+    if(v == c || v->nfree == 0)  // Racy peek; rechecked under the lock
+      continue;
+    acquire(&v->lock);
+    chain = takepages(&v->freelist, (v->nfree + 1) / 2, &n);
+    v->nfree -= n;
+    release(&v->lock);
+  }
+
+  if(chain == 0)
+    return 0;
+  acquire(&c->lock);
+  putpages(&c->freelist, chain->next);
+  c->nfree += n - 1;
+  release(&c->lock);
+  return chain;
+}
+
+// Take a page from the zeroed pool, or 0 if it is empty. Clearing
+// the link makes the page all zeros again.
+static struct run*
+zerotake(void)
+{
+  struct run *r;
+
+  acquire(&kzero.lock);
+  if((r = kzero.freelist) != 0){
+    kzero.freelist = r->next;
+    kzero.nfree--;
+  }
+  release(&kzero.lock);
+  if(r)
+    r->next = 0;
+  return r;
+}
+
+// Give the pages zeroed ahead of time back to the buddy allocator,
+// so that they can merge into larger blocks again.
+static void
+zerodrain(void)
+{
+  struct run *chain, *r;
+
+  acquire(&kzero.lock);
+  chain = kzero.freelist;
+  kzero.freelist = 0;
+  kzero.nfree = 0;
+  release(&kzero.lock);
+  if(chain == 0)
+    return;
+
+  acquire(&kmem.lock);
+  while(chain){
+    r = chain;
+    chain = r->next;
+    buddyfree((char*)r, 0);
+  }
+  release(&kmem.lock);
 }
 
 // Allocate one 4096-byte page of physical memory.
@@ -83,13 +416,176 @@ char*
 kalloc(void)
 {
   struct run *r;
+  struct kcache *c;
+  uint start;
 
-  if(kmem.use_lock)
-    acquire(&kmem.lock);
-  r = kmem.freelist;
-  if(r)
-    kmem.freelist = r->next;
-  if(kmem.use_lock)
-    release(&kmem.lock);
+  if(!kmem.use_lock){
+    if((r = (struct run*)buddyalloc(0)) != 0)
+      kmem.ref[V2P(r) / PGSIZE] = 1;
+    return (char*)r;
+  }
+
+  start = rdtsc();
+  pushcli();
+  c = &kmem.cache[cpuid()];
+  acquire(&c->lock);
+  r = c->freelist;
+  if(r){
+    c->freelist = r->next;
+    c->nfree--;
+  }
+  release(&c->lock);
+  if(r == 0)
+    r = refill(c);
+  if(r == 0)
+    r = zerotake();
+  if(r){
+    c->nalloc++;
+    addlatency(c->latency, rdtsc() - start);
+    kmem.ref[V2P(r) / PGSIZE] = 1;
+  }
+  popcli();
+  if(r == 0)
+    __sync_fetch_and_add(&kmem.nfail[0], 1);
   return (char*)r;
-}
\ No newline at end of file
+}
+
+// Allocate one page of physical memory filled with zeros, taking
+// one zeroed ahead of time if there is any.
+// Returns 0 if the memory cannot be allocated.
+char*
+kzalloc(void)
+{
+  struct kcache *c;
+  struct run *r;
+  char *mem;
+  uint start;
+
+  start = rdtsc();
+  if(kmem.use_lock && (r = zerotake()) != 0){
+    kmem.ref[V2P(r) / PGSIZE] = 1;
+    pushcli();
+    c = &kmem.cache[cpuid()];
+    c->nalloc++;
+    addlatency(c->latency, rdtsc() - start);
+    popcli();
+    return (char*)r;
+  }
+  if((mem = kalloc()) != 0)
+    memset(mem, 0, PGSIZE);
+  return mem;
+}
+
+// Zero a batch of free pages for kzalloc(), unless enough are
+// waiting already. The scheduler calls this when it finds nothing
+// to run.
+void
+kzerofill(void)
+{
+  char *pages[ZBATCH];
+  struct run *chain = 0, *r;
+  int i, n;
+
+  if(!kmem.use_lock || kzero.nfree >= NZEROED)  // Racy peek
+    return;
+  acquire(&kmem.lock);
+  for(n = 0; n < ZBATCH && (pages[n] = buddyalloc(0)) != 0; n++)
+    ;
+  release(&kmem.lock);
+  if(n == 0)
+    return;
+
+  for(i = 0; i < n; i++){
+    memset(pages[i], 0, PGSIZE);
+    r = (struct run*)pages[i];
+    r->next = chain;
+    chain = r;
+  }
+  acquire(&kzero.lock);
+  putpages(&kzero.freelist, chain);
+  kzero.nfree += n;
+  release(&kzero.lock);
+}
+
+// Allocate 2^order physically contiguous pages, aligned to their
+// size. Returns 0 if there is no free block that large.
+char*
+kalloc_order(int order)
+{
+  char *v;
+  uint start;
+
+  if(order == 0)
+    return kalloc();
+  if(order < 0 || order > KMEM_MAXORDER)
+    return 0;
+
+  start = rdtsc();
+  acquire(&kmem.lock);
+  v = buddyalloc(order);
+  if(v == 0 && kzero.freelist){  // Racy peek
+    release(&kmem.lock);
+    zerodrain();
+    acquire(&kmem.lock);
+    v = buddyalloc(order);
+  }
+  if(v){
+    kmem.ref[V2P(v) / PGSIZE] = 1;
+    kmem.nalloc[order]++;
+    addlatency(kmem.blocklatency, rdtsc() - start);
+  } else {
+    kmem.nfail[order]++;
+  }
+  release(&kmem.lock);
+  return v;
+}
+
+// Free a block returned by kalloc_order(order).
+void
+kfree_order(char *v, int order)
+{
+  if(order == 0){
+    kfree(v);
+    return;
+  }
+  if(order < 0 || order > KMEM_MAXORDER ||
+     V2P(v) % (PGSIZE << order) || v < end || V2P(v) >= PHYSTOP)
+    panic("kfree_order");
+  if(dropref(V2P(v)) > 0)
+    return;
+
+  memset(v, 1, PGSIZE << order);
+  acquire(&kmem.lock);
+  buddyfree(v, order);
+  release(&kmem.lock);
+}
+
+// Fill in allocator statistics. Pages sitting in the per-CPU
+// caches or zeroed ahead of time count as free single pages.
+void
+kmemstats(struct kmemstat *st)
+{
+  struct kcache *c;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  acquire(&kmem.lock);
+  for(i = 0; i <= KMEM_MAXORDER; i++){
+    st->nfree[i] = kmem.nfree[i];
+    st->nalloc[i] = kmem.nalloc[i];
+    st->nfail[i] = kmem.nfail[i];
+  }
+  for(i = 0; i < KMEM_NLAT; i++)
+    st->blocklatency[i] = kmem.blocklatency[i];
+  release(&kmem.lock);
+
+  for(c = kmem.cache; c < &kmem.cache[NCPU]; c++){
+    acquire(&c->lock);
+    st->cached += c->nfree;
+    st->nalloc[0] += c->nalloc;
+    for(i = 0; i < KMEM_NLAT; i++)
+      st->latency[i] += c->latency[i];
+    release(&c->lock);
+  }
+  st->zeroed = kzero.nfree;
+}
@@ -0,0 +1,81 @@
+// Page allocator stress test. Forks workers that keep growing and
+// shrinking their heaps with sbrk(), so every round allocates and
+// frees a batch of physical pages, and reports pages per tick.
+// Run with as many workers as CPUs to exercise the per-CPU caches.
+//
+// usage: kallocbench [workers] [ticks]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE 4096
+#define NPAGES 64
+#define MAXWORKERS 16
+
+void
+worker(int deadline, int fd)
+{
+  int rounds = 0;
+  char *p;
+  int i;
+
+  while(uptime() < deadline){
+    p = sbrk(NPAGES * PGSIZE);
+    if(p == (char*)-1)
+      break;
+    for(i = 0; i < NPAGES; i++)
+      p[i * PGSIZE] = i;
+    sbrk(-NPAGES * PGSIZE);
+    rounds++;
+  }
+  write(fd, &rounds, sizeof(rounds));
+}
+
+int
+main(int argc, char *argv[])
+{
+  int i, n, ticks, start, rounds, total = 0;
+  int fds[2];
+
+  n = argc > 1 ? atoi(argv[1]) : 4;
+  ticks = argc > 2 ? atoi(argv[2]) : 100;
+  if(n < 1 || n > MAXWORKERS || ticks < 1){
+    printf(2, "usage: kallocbench [workers] [ticks]\n");
+    exit();
+  }
+  if(pipe(fds) < 0){
+    printf(2, "kallocbench: pipe failed\n");
+    exit();
+  }
+
+  start = uptime();
+  for(i = 0; i < n; i++){
+    int pid = fork();
+    if(pid < 0){
+      printf(2, "kallocbench: fork failed\n");
+      n = i;
+      break;
+    }
+    if(pid == 0){
+      close(fds[0]);
+      worker(start + ticks, fds[1]);
+      exit();
+    }
+  }
+  close(fds[1]);
+
+  for(i = 0; i < n; i++){
+    if(read(fds[0], &rounds, sizeof(rounds)) != sizeof(rounds))
+      break;
+    total += rounds;
+  }
+  for(i = 0; i < n; i++)
+    wait();
+  ticks = uptime() - start;
+
+  printf(1, "kallocbench: %d workers, %d pages allocated and freed in %d ticks\n",
+         n, total * NPAGES, ticks);
+  printf(1, "kallocbench: %d pages/tick\n", total * NPAGES / (ticks ? ticks : 1));
+  exit();
+}
@@ -0,0 +1,59 @@
+// Print physical page allocator statistics: free blocks of each
+// order, how fragmented the free memory is and how long
+// allocations take.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "kmemstat.h"
+
+void
+printhist(char *what, uint *hist)
+{
+  int i;
+
+  printf(1, "%s latency (cycles):\n", what);
+  for(i = 0; i < KMEM_NLAT; i++){
+    if(hist[i] == 0)
+      continue;
+    printf(1, "  < %d\t%d\n", 1 << (i + KMEM_LATSHIFT + 1), hist[i]);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct kmemstat st;
+  int i, free = 0, below;
+
+  if(kmemstats(&st) < 0){
+    printf(2, "kmemstat: kmemstats failed\n");
+    exit();
+  }
+
+  printf(1, "order\tfree\tallocs\tfailed\n");
+  for(i = 0; i <= KMEM_MAXORDER; i++){
+    printf(1, "%d\t%d\t%d\t%d\n", i, st.nfree[i], st.nalloc[i], st.nfail[i]);
+    free += st.nfree[i] << i;
+  }
+  free += st.cached + st.zeroed;
+  printf(1, "free pages: %d (%d in per-CPU caches, %d zeroed)\n", free,
+         st.cached, st.zeroed);
+
+  // Share of free memory that cannot serve a request of each order
+  if(free > 0){
+    printf(1, "unusable for order:");
+    below = 0;
+    for(i = 0; i <= KMEM_MAXORDER; i++){
+      printf(1, " %d:%d%%", i, below * 100 / free);
+      below += st.nfree[i] << i;
+      if(i == 0)
+        below += st.cached + st.zeroed;
+    }
+    printf(1, "\n");
+  }
+
+  printhist("page", st.latency);
+  printhist("block", st.blocklatency);
+  exit();
+}
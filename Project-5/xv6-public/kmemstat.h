@@ -0,0 +1,19 @@
+#ifndef _KMEMSTAT_H_
+#define _KMEMSTAT_H_
+
+#define KMEM_MAXORDER 10   // Largest block is 2^10 pages (4MB)
+#define KMEM_NLAT 12       // Buckets in the latency histograms
+#define KMEM_LATSHIFT 6    // Bucket 0 holds latencies below 2^7 cycles
+
+// for `kmemstats`
+struct kmemstat {
+    int nfree[KMEM_MAXORDER+1];         // Free blocks of each order (2^order pages)
+    int cached;                         // Free pages held in per-CPU caches
+    int zeroed;                         // Free pages already zeroed
+    uint nalloc[KMEM_MAXORDER+1];       // Successful allocations of each order
+    uint nfail[KMEM_MAXORDER+1];        // Failed allocations of each order
+    uint latency[KMEM_NLAT];            // Single-page allocations; bucket i took
+                                        // under 2^(i+KMEM_LATSHIFT+1) cycles
+    uint blocklatency[KMEM_NLAT];       // Same for multi-page allocations
+};
+#endif // _KMEMSTAT_H_
@@ -11,16 +11,6 @@ static void mpmain(void)  __attribute__((noreturn));
 extern pde_t *kpgdir;
 extern char end[]; // first address after kernel loaded from ELF file
 
-// Add reference count array
-char ref_counts[MAX_PHYS_PAGES];
-
-// Add reference count initialization function
-static void
-refinit(void)
-{
-  memset(ref_counts, 0, MAX_PHYS_PAGES);
-}
-
 // Bootstrap processor starts running C code here.
 int
 main(void)
@@ -37,8 +27,10 @@ main(void)
   pinit();         // process table
   tvinit();        // trap vectors
   binit();         // buffer cache
+  pcacheinit();    // page cache
+  swapinit();      // swap space
+  anoninit();      // shared anonymous pages
   fileinit();      // file table
-  refinit();       // initialize reference counts
   ideinit();       // disk 
   startothers();   // start other processors
   kinit2(P2V(4*1024*1024), P2V(PHYSTOP)); // must come after startothers()
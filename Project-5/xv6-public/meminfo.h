@@ -0,0 +1,18 @@
+#ifndef _MEMINFO_H_
+#define _MEMINFO_H_
+
+// for `getmeminfo`. The kernel keeps these counts up to date as
+// pages come and go, so reading them walks no page tables.
+struct meminfo {
+    int pid;
+    char name[16];
+    uint sz;             // Size of process memory below the wmap area (bytes)
+    int rss;             // Resident pages, wmap pages included
+    int cow;             // Resident pages shared copy-on-write
+    int swapped;         // Pages in swap
+    uint minflt;         // Page faults served from memory
+    uint majflt;         // Page faults that read from disk or swap
+    uint cowbreaks;      // Copy-on-write faults
+    uint writeback;      // wmap pages written back to their files
+};
+#endif // _MEMINFO_H_
@@ -107,7 +107,8 @@ main(int argc, char *argv[])
 
   freeblock = nmeta;     // the first free block that we can allocate
 
-  for(i = 0; i < FSSIZE; i++)
+  // The swap area follows the file system
+  for(i = 0; i < FSSIZE + NSWAP * (4096 / BSIZE); i++)
     wsect(i, zeroes);
 
   memset(buf, 0, sizeof(buf));
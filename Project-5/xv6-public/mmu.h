@@ -86,6 +86,8 @@ struct segdesc {
 #define NPDENTRIES      1024    // # directory entries per page directory
 #define NPTENTRIES      1024    // # PTEs per page table
 #define PGSIZE          4096    // bytes mapped by a page
+#define HUGEPGSIZE      (PGSIZE*NPTENTRIES)  // bytes mapped by a PTE_PS PDE
+#define HUGEORDER       (PDXSHIFT-PTXSHIFT)  // kalloc_order() order of one
 
 #define PTXSHIFT        12      // offset of PTX in a linear address
 #define PDXSHIFT        22      // offset of PDX in a linear address
@@ -97,7 +99,15 @@ struct segdesc {
 #define PTE_P           0x001   // Present
 #define PTE_W           0x002   // Writeable
 #define PTE_U           0x004   // User
+#define PTE_A           0x020   // Accessed
+#define PTE_D           0x040   // Dirty
 #define PTE_PS          0x080   // Page Size    
+#define PTE_COW         0x200   // Copy-on-write (available to software)
+#define PTE_RA          0x400   // Mapped by read-ahead (available to software)
+#define PTE_SWAP        0x800   // Not present, page is in swap (available to software)
+
+// Page fault error code bits
+#define FEC_WR          0x002   // Fault was caused by a write
 
 // Address in page table or page directory entry
 #define PTE_ADDR(pte)   ((uint)(pte) & ~0xFFF)
@@ -0,0 +1,206 @@
+// Page cache for file-backed wmap regions.
+//
+// Every process that maps the same page of a file maps the same
+// physical page, looked up here by inode and file offset. readi and
+// writei go through a cached page when there is one, so read() and
+// write() agree with what mappings see.
+//
+// Interface:
+// * To get the page for a file offset, call pcget with the inode
+//   locked. It returns the page with a reference the caller owns,
+//   reading it from the file if it is not cached. pcpeek returns
+//   it only if it is cached.
+// * readi calls pcread and writei calls pcwrite for the inodes
+//   that have cached pages.
+// * iput calls pcinval when it drops an inode's last reference.
+// * reclaim calls pcshrink to free pages only the cache holds.
+//
+// The cache holds one kalloc reference to each page. Every PTE that
+// maps the page holds another, so a page whose count is 1 is used
+// only by the cache and can be replaced.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "file.h"
+
+#define NPCACHE 64
+
+struct cpage {
+  struct inode *ip;    // 0 if the slot is free
+  uint off;            // Page-aligned file offset
+  char *page;
+  uint stamp;          // Last use, for replacement
+};
+
+struct {
+  struct spinlock lock;
+  struct cpage pages[NPCACHE];
+  uint clock;
+} pcache;
+
+void
+pcacheinit(void)
+{
+  initlock(&pcache.lock, "pcache");
+}
+
+// Find the cached page of ip at off. pcache.lock must be held.
+static struct cpage*
+pclookup(struct inode *ip, uint off)
+{
+  struct cpage *c;
+
+  for(c = pcache.pages; c < &pcache.pages[NPCACHE]; c++){
+    if(c->ip == ip && c->off == off){
+      c->stamp = ++pcache.clock;
+      return c;
+    }
+  }
+  return 0;
+}
+
+// Return the cached page of ip that holds off, with a reference
+// for the caller, or 0 if it is not cached.
+char*
+pcpeek(struct inode *ip, uint off)
+{
+  struct cpage *c;
+  char *page = 0;
+
+  acquire(&pcache.lock);
+  if((c = pclookup(ip, PGROUNDDOWN(off))) != 0){
+    page = c->page;
+    incref(V2P(page));
+  }
+  release(&pcache.lock);
+  return page;
+}
+
+// Return the page of ip at page-aligned offset off, reading it from
+// the file on a miss. The caller must hold ip's lock, which keeps
+// anyone else from loading the same page meanwhile, and owns one
+// reference to the result. If every slot is in use by mappings the
+// page is returned uncached. Returns 0 if out of memory.
+char*
+pcget(struct inode *ip, uint off)
+{
+  struct cpage *c, *victim;
+  char *mem;
+  uint n;
+
+  if((mem = pcpeek(ip, off)) != 0)
+    return mem;
+
+  if((mem = kalloc()) == 0)
+    return 0;
+  memset(mem, 0, PGSIZE);
+  if(off < ip->size){
+    n = ip->size - off < PGSIZE ? ip->size - off : PGSIZE;
+    if(readi(ip, mem, off, n) != n){
+      kfree(mem);
+      return 0;
+    }
+  }
+
+  // Take a free slot, or else the least recently used page that
+  // nothing maps any more.
+  acquire(&pcache.lock);
+  victim = 0;
+  for(c = pcache.pages; c < &pcache.pages[NPCACHE]; c++){
+    if(c->ip == 0){
+      victim = c;
+      break;
+    }
+    if(get_refcount(V2P(c->page)) == 1 &&
+       (victim == 0 || c->stamp < victim->stamp))
+      victim = c;
+  }
+  if(victim){
+    if(victim->ip){
+      victim->ip->npcache--;
+      kfree(victim->page);
+    }
+    victim->ip = ip;
+    victim->off = off;
+    victim->page = mem;
+    victim->stamp = ++pcache.clock;
+    ip->npcache++;
+    incref(V2P(mem));
+  }
+  release(&pcache.lock);
+  return mem;
+}
+
+// Copy n bytes at off out of ip's cached page, if there is one.
+// The range must not cross a page boundary. Returns 1 on a hit.
+int
+pcread(struct inode *ip, char *dst, uint off, uint n)
+{
+  char *page;
+
+  if((page = pcpeek(ip, off)) == 0)
+    return 0;
+  memmove(dst, page + off % PGSIZE, n);
+  kfree(page);
+  return 1;
+}
+
+// Copy n bytes of new file data at off into ip's cached page,
+// if there is one. The range must not cross a page boundary.
+void
+pcwrite(struct inode *ip, char *src, uint off, uint n)
+{
+  char *page;
+
+  if((page = pcpeek(ip, off)) == 0)
+    return;
+  memmove(page + off % PGSIZE, src, n);
+  kfree(page);
+}
+
+// Free the cached pages that no mapping uses, for reclaim.
+// Returns how many it freed.
+int
+pcshrink(void)
+{
+  struct cpage *c;
+  int n = 0;
+
+  acquire(&pcache.lock);
+  for(c = pcache.pages; c < &pcache.pages[NPCACHE]; c++){
+    if(c->ip && get_refcount(V2P(c->page)) == 1){
+      c->ip->npcache--;
+      kfree(c->page);
+      c->ip = 0;
+      c->page = 0;
+      n++;
+    }
+  }
+  release(&pcache.lock);
+  return n;
+}
+
+// Drop all of ip's cached pages. Pages still mapped stay with
+// their mappings.
+void
+pcinval(struct inode *ip)
+{
+  struct cpage *c;
+
+  acquire(&pcache.lock);
+  for(c = pcache.pages; c < &pcache.pages[NPCACHE]; c++){
+    if(c->ip == ip){
+      kfree(c->page);
+      c->ip = 0;
+      c->page = 0;
+    }
+  }
+  ip->npcache = 0;
+  release(&pcache.lock);
+}
@@ -6,6 +6,7 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "meminfo.h"
 
 struct {
   struct spinlock lock;
@@ -88,6 +89,16 @@ allocproc(void)
 found:
   p->state = EMBRYO;
   p->pid = nextpid++;
+  p->nswap = 0;
+  p->swaphand = 0;
+  p->nextmapid = 0;
+  p->rss = 0;
+  p->ncow = 0;
+  p->nzero = 0;
+  p->minflt = 0;
+  p->majflt = 0;
+  p->ncowbreak = 0;
+  p->nwriteback = 0;
 
   release(&ptable.lock);
 
@@ -130,6 +141,7 @@ userinit(void)
     panic("userinit: out of memory?");
   inituvm(p->pgdir, _binary_initcode_start, (int)_binary_initcode_size);
   p->sz = PGSIZE;
+  p->rss = 1;
   memset(p->tf, 0, sizeof(*p->tf));
   p->tf->cs = (SEG_UCODE << 3) | DPL_USER;
   p->tf->ds = (SEG_UDATA << 3) | DPL_USER;
@@ -154,6 +166,9 @@ userinit(void)
 }
 
 // Grow current process's memory by n bytes.
+// Growing only moves the end; pagefault fills the new pages in
+// when they are first touched. The heap stops short of the wmap
+// area at MMAPBASE.
 // Return 0 on success, -1 on failure.
 int
 growproc(int n)
@@ -163,8 +178,9 @@ growproc(int n)
 
   sz = curproc->sz;
   if(n > 0){
-    if((sz = allocuvm(curproc->pgdir, sz, sz + n)) == 0)
+    if(sz + n < sz || sz + n > MMAPBASE)
       return -1;
+    sz += n;
   } else if(n < 0){
     if((sz = deallocuvm(curproc->pgdir, sz, sz + n)) == 0)
       return -1;
@@ -200,8 +216,6 @@ fork(void)
   np->parent = curproc;
   *np->tf = *curproc->tf;
 
-  // Copy memory mappings count
-  np->total_mmaps = curproc->total_mmaps;
 
   // Clear %eax so that fork returns 0 in the child.
   np->tf->eax = 0;
@@ -210,6 +224,9 @@ fork(void)
     if(curproc->ofile[i])
       np->ofile[i] = filedup(curproc->ofile[i]);
   np->cwd = idup(curproc->cwd);
+  np->exe = curproc->exe ? idup(curproc->exe) : 0;
+  np->nseg = curproc->nseg;
+  memmove(np->segs, curproc->segs, sizeof(np->segs));
 
   safestrcpy(np->name, curproc->name, sizeof(curproc->name));
 
@@ -237,6 +254,9 @@ exit(void)
   if(curproc == initproc)
     panic("init exiting");
 
+  // Write back and drop memory mappings.
+  vmafree(curproc);
+
   // Close all open files.
   for(fd = 0; fd < NOFILE; fd++){
     if(curproc->ofile[fd]){
@@ -247,8 +267,12 @@ exit(void)
 
   begin_op();
   iput(curproc->cwd);
+  if(curproc->exe)
+    iput(curproc->exe);
   end_op();
   curproc->cwd = 0;
+  curproc->exe = 0;
+  curproc->nseg = 0;
 
   acquire(&ptable.lock);
 
@@ -327,6 +351,7 @@ scheduler(void)
 {
   struct proc *p;
   struct cpu *c = mycpu();
+  int ran;
   c->proc = 0;
   
   for(;;){
@@ -334,6 +359,7 @@ scheduler(void)
     sti();
 
     // Loop over process table looking for process to run.
+    ran = 0;
     acquire(&ptable.lock);
     for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
       if(p->state != RUNNABLE)
@@ -345,6 +371,7 @@ scheduler(void)
       c->proc = p;
       switchuvm(p);
       p->state = RUNNING;
+      ran = 1;
 
       swtch(&(c->scheduler), p->context);
       switchkvm();
@@ -355,6 +382,9 @@ scheduler(void)
     }
     release(&ptable.lock);
 
+    // Idle: clear pages for the next faults on fresh memory
+    if(!ran)
+      kzerofill();
   }
 }
 
@@ -499,6 +529,35 @@ kill(int pid)
   return -1;
 }
 
+// Fill in *mi for the process in slot i of the process table.
+// Returns -1 if the slot is unused or out of range.
+int
+procmeminfo(int i, struct meminfo *mi)
+{
+  struct proc *p;
+
+  if(i < 0 || i >= NPROC)
+    return -1;
+  acquire(&ptable.lock);
+  p = &ptable.proc[i];
+  if(p->state == UNUSED || p->state == EMBRYO){
+    release(&ptable.lock);
+    return -1;
+  }
+  mi->pid = p->pid;
+  safestrcpy(mi->name, p->name, sizeof(mi->name));
+  mi->sz = p->sz;
+  mi->rss = p->rss;
+  mi->cow = p->ncow;
+  mi->swapped = p->nswap;
+  mi->minflt = p->minflt;
+  mi->majflt = p->majflt;
+  mi->cowbreaks = p->ncowbreak;
+  mi->writeback = p->nwriteback;
+  release(&ptable.lock);
+  return 0;
+}
+
 //PAGEBREAK: 36
 // Print a process listing to console.  For debugging.
 // Runs when user types ^P on console.
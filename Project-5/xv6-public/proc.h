@@ -1,4 +1,4 @@
-#define NMMAPS 16  // Maximum number of memory mappings per process
+#define NMMAPS 512  // Maximum number of memory mappings per process
 
 // Structure to track memory mapped regions
 struct vm_area {
@@ -7,7 +7,22 @@ struct vm_area {
   int flags;          // Mapping flags (MAP_SHARED, etc.)
   struct inode *ip;    // Mapped file's inode (NULL for anonymous)
   uint offset;         // Offset into the file
-  int used;           // Is this vm_area in use?
+  int nhuge;          // 4MB pages mapped for MAP_HUGE
+  uint ranext;        // Where the last read-ahead window ended
+  int rawin;          // Current read-ahead window, in pages
+  int nfault;         // Page faults taken
+  uint id;            // wmap call that created it (sys_wmap)
+  struct anon *anon;  // Pages shared since fork (anon.c), or 0
+};
+
+// A loadable segment of the program a process runs, which exec
+// leaves to be paged in from p->exe on first touch.
+struct segment {
+  uint va;             // Page-aligned start
+  uint memsz;          // Bytes in memory
+  uint filesz;         // Of those, bytes from the file
+  uint off;            // File offset of va
+  int writable;
 };
 
 // Per-CPU state
@@ -61,13 +76,24 @@ struct proc {
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
   char name[16];               // Process name (debugging)
-  struct vm_area mmaps[NMMAPS];  // Memory mapped regions
-  int total_mmaps;            // Number of active memory mappings
+  struct inode *exe;           // Program file, or 0 (exec.c)
+  struct segment segs[NSEG];   // Its segments not loaded by exec
+  int nseg;
+  struct vm_area *mmaps;       // Memory mapped regions, sorted (vma.c)
+  int total_mmaps;             // Number of active memory mappings
+  int mmaporder;               // kalloc_order() order of mmaps
+  uint nextmapid;              // id for the next wmap region
+  int nswap;                   // Pages in swap (swap.c)
+  uint swaphand;               // Where reclaim's clock stopped
+  int rss;                     // Resident user pages (see meminfo.h)
+  int ncow;                    // Of those, pages shared copy-on-write
+  int nzero;                   // wmap pages mapping the zero page (vm.c)
+  uint minflt;                 // Page faults served from memory
+  uint majflt;                 // Page faults that read from disk
+  uint ncowbreak;              // Copy-on-write faults
+  uint nwriteback;             // wmap pages written back to files
 };
 
-// For copy-on-write reference counting (add at the end of the file)
-#define MAX_PHYS_PAGES (1024*1024)  // 4GB/4KB = 1M pages maximum
-extern char ref_counts[MAX_PHYS_PAGES];  // Reference count array
 // Process memory is laid out contiguously, low addresses first:
 //   text
 //   original data and bss
@@ -0,0 +1,253 @@
+// Swap space and page reclaim.
+//
+// The NSWAP pages of disk right after the file system hold pages
+// of anonymous wmap regions that were evicted when memory ran out.
+// An evicted page's PTE is left not present, with PTE_SWAP set and
+// the swap slot number where the page frame number would be.
+//
+// When a fault finds no free page, it calls reclaim, which runs a
+// clock over the PTEs of the current process's wmap regions. A page
+// whose accessed bit is set has it cleared and gets a second
+// chance; otherwise a clean file page is dropped, to fault back in
+// from the page cache or the file, and an anonymous page is written
+// to swap. Only the current process is scanned, since xv6 cannot
+// flush another CPU's TLB, and pages in page tables still shared
+// after fork are left alone.
+//
+// After fork a swapped-out PTE can sit in a page table that several
+// processes share, and ptunshare copies it into each process's own
+// table. Slots are therefore counted, one reference per page table
+// that holds the PTE. The first of them to fault the page in keeps
+// it in swap.page while the slot has other references, and the rest
+// map that same page, so writes to a MAP_SHARED region still reach
+// every sharer. The slot and its cached page go once the last PTE
+// has been faulted in or freed.
+
+#include "types.h"
+#include "x86.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+#include "fs.h"
+#include "buf.h"
+#include "proc.h"
+#include "wmap.h"
+
+#define SWAPSTART FSSIZE         // First disk block of swap
+#define PGBLOCKS (PGSIZE/BSIZE)  // Disk blocks per page
+#define NRECLAIM 16              // Pages reclaim tries to free per call
+
+struct {
+  struct spinlock lock;
+  ushort ref[NSWAP];             // Page tables holding each slot
+  char *page[NSWAP];             // Where a shared slot was read in, or 0
+  int next;                      // Where to start looking for a free slot
+} swap;
+
+void
+swapinit(void)
+{
+  initlock(&swap.lock, "swap");
+}
+
+static int
+slotalloc(void)
+{
+  int i, s;
+
+  acquire(&swap.lock);
+  for(i = 0; i < NSWAP; i++){
+    s = (swap.next + i) % NSWAP;
+    if(swap.ref[s] == 0){
+      swap.ref[s] = 1;
+      swap.next = s + 1;
+      release(&swap.lock);
+      return s;
+    }
+  }
+  release(&swap.lock);
+  return -1;
+}
+
+// Drop a reference to slot s. The last one frees the slot and
+// returns its cached page, whose reference the caller must drop.
+// swap.lock must be held.
+static char*
+slotput(int s)
+{
+  char *page = 0;
+
+  if(swap.ref[s] == 0)
+    panic("slotput");
+  if(--swap.ref[s] == 0){
+    page = swap.page[s];
+    swap.page[s] = 0;
+  }
+  return page;
+}
+
+// Copy a page to or from swap slot s.
+static void
+swapio(char *page, int s, int write)
+{
+  struct buf *b;
+  int i;
+
+  for(i = 0; i < PGBLOCKS; i++){
+    b = bread(ROOTDEV, SWAPSTART + s * PGBLOCKS + i);
+    if(write){
+      memmove(b->data, page + i * BSIZE, BSIZE);
+      bwrite(b);
+    } else
+      memmove(page + i * BSIZE, b->data, BSIZE);
+    brelse(b);
+  }
+}
+
+// Write the page that pte maps in p to swap and free it.
+// Returns -1 if swap is full.
+static int
+swapout(struct proc *p, pte_t *pte)
+{
+  char *page = P2V(PTE_ADDR(*pte));
+  int s;
+
+  if((s = slotalloc()) < 0)
+    return -1;
+  swapio(page, s, 1);
+  *pte = (s << PTXSHIFT) | (*pte & (PTE_W|PTE_U)) | PTE_SWAP;
+  kfree(page);
+  p->nswap++;
+  p->rss--;
+  return 0;
+}
+
+// Map the swapped-out page of p that pte refers to, reading it back
+// into a new page unless another sharer of the slot already has.
+// pte must be in a page table p does not share. Returns -1 if out
+// of memory.
+int
+swapin(struct proc *p, pte_t *pte)
+{
+  char *mem, *new, *old;
+  int s = PTE_ADDR(*pte) >> PTXSHIFT;
+
+  acquire(&swap.lock);
+  if((mem = swap.page[s]) != 0)
+    incref(V2P(mem));
+  release(&swap.lock);
+
+  new = 0;
+  if(mem == 0){
+    if((new = kalloc()) == 0)
+      return -1;
+    swapio(new, s, 0);
+  }
+
+  acquire(&swap.lock);
+  // Another sharer may have read it in meanwhile
+  if(mem == 0 && (mem = swap.page[s]) != 0)
+    incref(V2P(mem));
+  if(mem == 0){
+    mem = new;
+    new = 0;
+    if(swap.ref[s] > 1){
+      swap.page[s] = mem;
+      incref(V2P(mem));  // The reference swap.page holds
+    }
+  }
+  old = slotput(s);
+  release(&swap.lock);
+  if(new)
+    kfree(new);
+  if(old)
+    kfree(old);
+  *pte = V2P(mem) | (*pte & (PTE_W|PTE_U)) | PTE_P;
+  p->nswap--;
+  p->rss++;
+  return 0;
+}
+
+// Take another reference to the swap slot of a swapped-out PTE,
+// for a copy of the page table that holds it.
+void
+swapdup(pte_t pte)
+{
+  acquire(&swap.lock);
+  swap.ref[PTE_ADDR(pte) >> PTXSHIFT]++;
+  release(&swap.lock);
+}
+
+// Drop the reference a swapped-out PTE holds to its slot.
+void
+swapfree(pte_t pte)
+{
+  char *page;
+
+  acquire(&swap.lock);
+  page = slotput(PTE_ADDR(pte) >> PTXSHIFT);
+  release(&swap.lock);
+  if(page)
+    kfree(page);
+}
+
+// Evict up to NRECLAIM pages of the current process's wmap regions.
+// Returns how many pages it unmapped or freed, 0 if it found none.
+int
+reclaim(void)
+{
+  struct proc *p = myproc();
+  struct vm_area *m;
+  uint va, npages, scanned;
+  pde_t pde;
+  pte_t *pte;
+  int n;
+
+  // Cached file pages that nothing maps go first
+  n = pcshrink();
+
+  npages = 0;
+  for(m = p->mmaps; m < p->mmaps + p->total_mmaps; m++)
+    npages += PGROUNDUP(m->length) / PGSIZE;
+
+  // Two trips around clear every accessed bit at most once
+  va = p->swaphand;
+  for(scanned = 0; n < NRECLAIM && scanned < 2 * npages;
+      scanned++, va += PGSIZE){
+    if(va < MMAPBASE || va >= KERNBASE ||
+       (m = vmaoverlap(p, va, KERNBASE - va)) == 0){
+      if((m = vmaoverlap(p, MMAPBASE, KERNBASE - MMAPBASE)) == 0)
+        break;
+      va = m->addr;
+    }
+    if(va < m->addr)
+      va = m->addr;
+
+    pde = p->pgdir[PDX(va)];
+    if(!(pde & PTE_P) || (pde & (PTE_PS|PTE_COW)))
+      continue;
+    pte = walkpgdir(p->pgdir, (void*)va, 0);
+    if(!(*pte & PTE_P))
+      continue;
+    if(*pte & PTE_A){
+      *pte &= ~PTE_A;
+      continue;
+    }
+    if(m->flags & MAP_ANONYMOUS){
+      // A page another process still maps cannot go to swap
+      if(get_refcount(PTE_ADDR(*pte)) == 1 && swapout(p, pte) == 0)
+        n++;
+    } else if(!(*pte & PTE_D)){
+      kfree(P2V(PTE_ADDR(*pte)));
+      *pte = 0;
+      p->rss--;
+      n++;
+    }
+  }
+  p->swaphand = va;
+  lcr3(V2P(p->pgdir));
+  return n + pcshrink();
+}
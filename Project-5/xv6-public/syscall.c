@@ -21,6 +21,8 @@ fetchint(uint addr, int *ip)
 
   if(addr >= curproc->sz || addr+4 > curproc->sz)
     return -1;
+  if(uvmprefault(addr, 4, 0) < 0)
+    return -1;
   *ip = *(int*)(addr);
   return 0;
 }
@@ -39,6 +41,8 @@ fetchstr(uint addr, char **pp)
   *pp = (char*)addr;
   ep = (char*)curproc->sz;
   for(s = *pp; s < ep; s++){
+    if((s == *pp || (uint)s % PGSIZE == 0) && uvmprefault((uint)s, 1, 0) < 0)
+      return -1;
     if(*s == 0)
       return s - *pp;
   }
@@ -65,6 +69,8 @@ argptr(int n, char **pp, int size)
     return -1;
   if(size < 0 || (uint)i >= curproc->sz || (uint)i+size > curproc->sz)
     return -1;
+  if(uvmprefault(i, size, 0) < 0)
+    return -1;
   *pp = (char*)i;
   return 0;
 }
@@ -107,6 +113,11 @@ extern int sys_wmap(void);
 extern int sys_wunmap(void);
 extern int sys_va2pa(void);
 extern int sys_getwmapinfo(void);
+extern int sys_kmemstats(void);
+extern int sys_wmsync(void);
+extern int sys_wremap(void);
+extern int sys_wunmaprange(void);
+extern int sys_getmeminfo(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -134,6 +145,11 @@ static int (*syscalls[])(void) = {
 [SYS_wunmap]  sys_wunmap,
 [SYS_va2pa]   sys_va2pa,
 [SYS_getwmapinfo]   sys_getwmapinfo,
+[SYS_kmemstats]   sys_kmemstats,
+[SYS_wmsync]      sys_wmsync,
+[SYS_wremap]      sys_wremap,
+[SYS_wunmaprange] sys_wunmaprange,
+[SYS_getmeminfo] sys_getmeminfo,
 };
 
 void
@@ -23,4 +23,9 @@
 #define SYS_wmap 22
 #define SYS_wunmap 23
 #define SYS_va2pa 24
-#define SYS_getwmapinfo 25
\ No newline at end of file
+#define SYS_getwmapinfo 25
+#define SYS_kmemstats 26
+#define SYS_wmsync 27
+#define SYS_wremap 28
+#define SYS_wunmaprange 29
+#define SYS_getmeminfo 30
\ No newline at end of file
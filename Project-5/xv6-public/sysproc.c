@@ -9,6 +9,8 @@
 #include "spinlock.h"    
 #include "sleeplock.h"   
 #include "wmap.h"
+#include "kmemstat.h"
+#include "meminfo.h"
 #include "fs.h"
 #include "file.h"
 
@@ -109,56 +111,51 @@ sys_wmap(void)
   if(length <= 0)
     return FAILED;
   
-  if((flags & MAP_FIXED) == 0)
+  if((flags & (MAP_FIXED | MAP_FIRSTFIT | MAP_BESTFIT)) == 0)
     return FAILED;
 
   if((flags & MAP_SHARED) == 0)
     return FAILED;
 
-  // Address range check
-  if(addr < 0x60000000 || addr >= 0x80000000 || addr % PGSIZE != 0)
-    return FAILED;
-
   struct proc *p = myproc();
-  int i;
-
-  // Find free mapping slot
-  for(i = 0; i < NMMAPS; i++) {
-    if(!p->mmaps[i].used)
-      break;
-  }
-  if(i == NMMAPS)
-    return FAILED;
-
-  // Check if address range is available
-  for(int j = 0; j < NMMAPS; j++) {
-    if(p->mmaps[j].used) {
-      if((addr >= p->mmaps[j].addr && 
-          addr < p->mmaps[j].addr + p->mmaps[j].length) ||
-         (addr + length > p->mmaps[j].addr && 
-          addr + length <= p->mmaps[j].addr + p->mmaps[j].length))
+  struct vm_area *m;
+  struct inode *ip = 0;
+  uint align;
+
+  // Without MAP_FIXED, addr is only a hint: use it if the range is
+  // free, else let the kernel pick a gap. Large anonymous huge maps
+  // get a 4MB-aligned start so they can use 4MB pages throughout.
+  if((flags & MAP_FIXED) == 0){
+    if(addr < MMAPBASE || addr >= KERNBASE || addr % PGSIZE != 0 ||
+       length > KERNBASE - addr || vmaoverlap(p, addr, length)){
+      align = PGSIZE;
+      if((flags & (MAP_HUGE | MAP_ANONYMOUS)) == (MAP_HUGE | MAP_ANONYMOUS) &&
+         length >= HUGEPGSIZE)
+        align = HUGEPGSIZE;
+      if((addr = vmaplace(p, length, align, flags & MAP_BESTFIT)) == 0)
         return FAILED;
     }
   }
 
-  // Set up mapping
-  p->mmaps[i].addr = addr;
-  p->mmaps[i].length = length;
-  p->mmaps[i].flags = flags;
-  p->mmaps[i].used = 1;
-  p->mmaps[i].offset = 0;
-  p->mmaps[i].ip = 0;
+  // Address range check
+  if(addr < MMAPBASE || addr >= KERNBASE || addr % PGSIZE != 0 ||
+     length > KERNBASE - addr)
+    return FAILED;
 
   // Handle file-backed mapping
   if(!(flags & MAP_ANONYMOUS)) {
     if(fd < 0 || fd >= NOFILE || (p->ofile[fd] == 0))
       return FAILED;
-    p->mmaps[i].ip = p->ofile[fd]->ip;
-    // Increment ref count on inode
-    idup(p->mmaps[i].ip);
+    ip = p->ofile[fd]->ip;
   }
 
-  p->total_mmaps++;
+  // Fails if the range overlaps another mapping
+  if((m = vmainsert(p, addr, length)) == 0)
+    return FAILED;
+  m->flags = flags;
+  m->id = p->nextmapid++;
+  if(ip)
+    m->ip = idup(ip);  // Increment ref count on inode
   return addr;
 }
 
@@ -170,70 +167,126 @@ sys_wunmap(void)
     return FAILED;
 
   struct proc *p = myproc();
-  int i;
+  struct vm_area *m;
 
   // Find the mapping
-  for(i = 0; i < NMMAPS; i++) {
-    if(p->mmaps[i].used && p->mmaps[i].addr == addr)
-      break;
-  }
-  if(i == NMMAPS)
+  if((m = vmafind(p, addr)) == 0 || m->addr != addr)
     return FAILED;
 
-  // File-backed mapping: write back first if needed
-  if(!(p->mmaps[i].flags & MAP_ANONYMOUS) && (p->mmaps[i].flags & MAP_SHARED)) {   
-   uint chunk_size = 512;  // Standard block size
-   uint remaining = p->mmaps[i].length;
-   uint current_addr = addr;
-   
-   while(remaining > 0) {
-       begin_op();
-       ilock(p->mmaps[i].ip);
-       
-       uint write_size = (remaining < chunk_size) ? remaining : chunk_size;
-       pte_t *pte = walkpgdir(p->pgdir, (void*)current_addr, 0);
-       
-       if(pte && (*pte & PTE_P)) {
-           char *mem = P2V(PTE_ADDR(*pte));
-           uint offset = current_addr - p->mmaps[i].addr;           
-           
-           if(writei(p->mmaps[i].ip, mem + (offset % PGSIZE), offset, write_size) != write_size) {
-               iunlock(p->mmaps[i].ip);
-               end_op();
-               return FAILED;
-           }
-       }
-       
-       iunlock(p->mmaps[i].ip);
-       end_op();
-       
-       remaining -= write_size;
-       current_addr += write_size;
-   }
-   
+  if(vmaunmap(p, addr, addr + m->length) < 0)
+    return FAILED;
+  return SUCCESS;
 }
 
-  // Clean up memory and page table entries
-  pte_t *pte;
-  uint va;
-  for(va = addr; va < addr + p->mmaps[i].length; va += PGSIZE) {
-    if((pte = walkpgdir(p->pgdir, (void*)va, 0)) != 0 && (*pte & PTE_P)) {
-      char *v = P2V(PTE_ADDR(*pte));
-      kfree(v);
-      *pte = 0;
-    }
+// Unmap the pages in [addr, addr+length), which may cover parts of
+// several mappings. A mapping cut in the middle is split in two.
+int
+sys_wunmaprange(void)
+{
+  uint addr;
+  int length;
+
+  if(argint(0, (int*)&addr) < 0 || argint(1, &length) < 0)
+    return FAILED;
+  if(addr % PGSIZE != 0 || length <= 0 || addr + length < addr)
+    return FAILED;
+  if(vmaunmap(myproc(), addr, addr + length) < 0)
+    return FAILED;
+  return SUCCESS;
+}
+
+// Resize the mapping at oldaddr from oldsize to newsize bytes. It
+// grows in place if the pages after it are free, and otherwise,
+// with MREMAP_MAYMOVE, moves to a free range by moving its page
+// table entries, so loaded pages come along without a copy.
+// Returns the mapping's address.
+int
+sys_wremap(void)
+{
+  uint oldaddr, newaddr, end, align, slack;
+  int oldsize, newsize, flags;
+  struct proc *p = myproc();
+  struct vm_area *m, *n;
+
+  if(argint(0, (int*)&oldaddr) < 0 || argint(1, &oldsize) < 0 ||
+     argint(2, &newsize) < 0 || argint(3, &flags) < 0)
+    return FAILED;
+  if((m = vmafind(p, oldaddr)) == 0 || m->addr != oldaddr ||
+     m->length != oldsize || newsize <= 0 || (flags & ~MREMAP_MAYMOVE))
+    return FAILED;
+
+  // Shrink, dropping the whole pages past the new end
+  if(newsize <= oldsize){
+    end = PGROUNDUP(oldaddr + newsize);
+    if(end < oldaddr + oldsize && vmaunmap(p, end, oldaddr + oldsize) < 0)
+      return FAILED;
+    vmafind(p, oldaddr)->length = newsize;
+    return oldaddr;
   }
 
-  // Release file if needed
-  if(!(p->mmaps[i].flags & MAP_ANONYMOUS)) {
-    begin_op();
-    iput(p->mmaps[i].ip);
-    end_op();
+  // Grow in place
+  end = PGROUNDUP(oldaddr + oldsize);
+  if(newsize <= KERNBASE - oldaddr &&
+     (oldaddr + newsize <= end ||
+      vmaoverlap(p, end, oldaddr + newsize - end) == 0)){
+    m->length = newsize;
+    vmamerge(p, m);
+    return oldaddr;
   }
+  if(!(flags & MREMAP_MAYMOVE))
+    return FAILED;
 
-  memset(&p->mmaps[i], 0, sizeof(p->mmaps[i]));
-  p->total_mmaps--;
-  return SUCCESS;
+  // Move, keeping the offset within a 4MB page so 4MB pages move whole
+  align = PGSIZE;
+  slack = 0;
+  if(m->flags & MAP_HUGE){
+    align = HUGEPGSIZE;
+    slack = oldaddr % HUGEPGSIZE;
+  }
+  if((newaddr = vmaplace(p, newsize + slack, align, 0)) == 0)
+    return FAILED;
+  newaddr += slack;
+  if((n = vmainsert(p, newaddr, newsize)) == 0)
+    return FAILED;
+  m = vmafind(p, oldaddr);  // The table may have moved
+  if(wmmove(p->pgdir, oldaddr, newaddr, oldsize) < 0){
+    vmaremove(p, n);
+    return FAILED;
+  }
+  n->flags = m->flags;
+  n->id = m->id;
+  n->ip = m->ip;  // The file and anon references move with the mapping
+  n->anon = m->anon;
+  n->offset = m->offset;
+  n->nhuge = m->nhuge;
+  n->nfault = m->nfault;
+  vmaremove(p, m);
+  return newaddr;
+}
+
+// Write the modified pages of the file-backed mappings that
+// overlap [addr, addr+length) back to their files.
+int
+sys_wmsync(void)
+{
+  uint addr;
+  int length, found = 0;
+  struct proc *p = myproc();
+  struct vm_area *m;
+
+  if(argint(0, (int*)&addr) < 0 || argint(1, &length) < 0)
+    return FAILED;
+  if(addr % PGSIZE != 0 || length <= 0)
+    return FAILED;
+
+  m = vmaoverlap(p, addr, length);
+  for(; m && m < p->mmaps + p->total_mmaps && m->addr < addr + length; m++) {
+    found = 1;
+    if(!(m->flags & MAP_ANONYMOUS) && (m->flags & MAP_SHARED) &&
+       wmwriteback(m, addr, addr + length) < 0)
+      return FAILED;
+  }
+  return found ? SUCCESS : FAILED;
 }
 
 uint
@@ -245,7 +298,10 @@ sys_va2pa(void)
 
   pte_t *pte;
   struct proc *p = myproc();
+  pde_t pde = p->pgdir[PDX(va)];
 
+  if(pde & PTE_PS)
+    return (pde & ~(HUGEPGSIZE-1)) | (va & (HUGEPGSIZE-1));
   if((pte = walkpgdir(p->pgdir, (void*)va, 0)) == 0)
     return -1;
 
@@ -259,32 +315,75 @@ int
 sys_getwmapinfo(void)
 {
   struct wmapinfo *wminfo;
-  if(argptr(0, (char**)&wminfo, sizeof(*wminfo)) < 0)
+  if(argptr(0, (char**)&wminfo, sizeof(*wminfo)) < 0 ||
+     uvmprefault((uint)wminfo, sizeof(*wminfo), 1) < 0)
     return FAILED;
 
   struct proc *p = myproc();
   wminfo->total_mmaps = p->total_mmaps;
   
-  int idx = 0;
-  for(int i = 0; i < NMMAPS && idx < MAX_WMMAP_INFO; i++) {
-    if(p->mmaps[i].used) {
-      wminfo->addr[idx] = p->mmaps[i].addr;
-      wminfo->length[idx] = p->mmaps[i].length;
-      
-      // Count loaded pages
-      int count = 0;
-      uint va;
-      for(va = p->mmaps[i].addr; 
-          va < p->mmaps[i].addr + p->mmaps[i].length; 
-          va += PGSIZE) {
-        pte_t *pte;
-        if((pte = walkpgdir(p->pgdir, (void*)va, 0)) != 0 && (*pte & PTE_P))
-          count++;
+  int idx;
+  for(idx = 0; idx < p->total_mmaps && idx < MAX_WMMAP_INFO; idx++) {
+    struct vm_area *m = &p->mmaps[idx];
+    wminfo->addr[idx] = m->addr;
+    wminfo->length[idx] = m->length;
+
+    // Count loaded pages
+    int count = 0;
+    int huge = 0, saved = 0;
+    uint va;
+    for(va = m->addr; va < m->addr + m->length; va += PGSIZE) {
+      pte_t *pte;
+      if(p->pgdir[PDX(va)] & PTE_PS) {
+        count += NPTENTRIES;
+        huge++;
+        va += HUGEPGSIZE - PGSIZE;
+        continue;
       }
-      wminfo->n_loaded_pages[idx] = count;
-      idx++;
+      if((pte = walkpgdir(p->pgdir, (void*)va, 0)) != 0 && (*pte & PTE_P))
+        count++;
+      if(pte && (*pte & (PTE_P|PTE_RA|PTE_A)) == (PTE_P|PTE_RA|PTE_A))
+        saved++;
     }
+    wminfo->n_loaded_pages[idx] = count;
+    wminfo->n_huge_pages[idx] = huge;
+    wminfo->n_faults[idx] = m->nfault;
+    wminfo->n_faults_saved[idx] = saved;
   }
   
   return SUCCESS;
-}
\ No newline at end of file
+}
+
+int
+sys_kmemstats(void)
+{
+  struct kmemstat *st;
+  struct kmemstat kst;
+
+  if(argptr(0, (char**)&st, sizeof(*st)) < 0 ||
+     uvmprefault((uint)st, sizeof(*st), 1) < 0)
+    return FAILED;
+
+  // Gather under the allocator locks, then copy out without them
+  kmemstats(&kst);
+  memmove(st, &kst, sizeof(kst));
+  return SUCCESS;
+}
+
+// Copy the memory counters of the process in process-table slot i
+// to user space. Fails if the slot is unused.
+int
+sys_getmeminfo(void)
+{
+  int i;
+  struct meminfo *mi;
+  struct meminfo kmi;
+
+  if(argint(0, &i) < 0 || argptr(1, (char**)&mi, sizeof(*mi)) < 0 ||
+     uvmprefault((uint)mi, sizeof(*mi), 1) < 0)
+    return FAILED;
+  if(procmeminfo(i, &kmi) < 0)
+    return FAILED;
+  memmove(mi, &kmi, sizeof(kmi));
+  return SUCCESS;
+}
@@ -0,0 +1,54 @@
+// Show each process's memory use and paging activity, from the
+// counters the kernel keeps rather than a page table walk.
+// Counts are in pages. With a round count, repeats that many times,
+// showing the faults taken since the previous round.
+//
+// usage: top [rounds [ticks]]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "param.h"
+#include "meminfo.h"
+
+struct meminfo last[NPROC];
+
+int
+main(int argc, char *argv[])
+{
+  struct meminfo mi;
+  int i, r, rounds, ticks;
+  uint minflt, majflt;
+
+  rounds = argc > 1 ? atoi(argv[1]) : 1;
+  ticks = argc > 2 ? atoi(argv[2]) : 100;
+  if(rounds < 1 || ticks < 1){
+    printf(2, "usage: top [rounds [ticks]]\n");
+    exit();
+  }
+
+  for(r = 0; r < rounds; r++){
+    if(r > 0){
+      sleep(ticks);
+      printf(1, "\n");
+    }
+    printf(1, "PID\tNAME\tSIZE\tRSS\tCOW\tSWAP\tMINFLT\tMAJFLT\tCOWBRK\tWBACK\n");
+    for(i = 0; i < NPROC; i++){
+      if(getmeminfo(i, &mi) < 0){
+        last[i].pid = 0;
+        continue;
+      }
+      minflt = mi.minflt;
+      majflt = mi.majflt;
+      if(r > 0 && last[i].pid == mi.pid){
+        minflt -= last[i].minflt;
+        majflt -= last[i].majflt;
+      }
+      printf(1, "%d\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\n", mi.pid, mi.name,
+             mi.sz / 4096, mi.rss, mi.cow, mi.swapped, minflt, majflt,
+             mi.cowbreaks, mi.writeback);
+      last[i] = mi;
+    }
+  }
+  exit();
+}
@@ -49,93 +49,25 @@ trap(struct trapframe *tf)
   }
 
   switch(tf->trapno){
-  case T_PGFLT: {
-    uint va = rcr2();  // Get the faulting virtual address
-    struct proc *p = myproc();
-    int i;
-
-    // Check if it's a page fault in mapped region
-    for(i = 0; i < NMMAPS; i++) {
-      if(p->mmaps[i].used && 
-         va >= p->mmaps[i].addr && 
-         va < p->mmaps[i].addr + p->mmaps[i].length) {
-        
-        char *mem;
-        uint aligned_addr = PGROUNDDOWN(va);
-        pte_t *pte = walkpgdir(p->pgdir, (void*)aligned_addr, 0);
-
-        // Handle copy-on-write if needed
-        if(pte && (*pte & PTE_P) && !(*pte & PTE_W)) {
-          uint pa = PTE_ADDR(*pte);
-          if(ref_counts[pa/PGSIZE] > 1) {
-            if((mem = kalloc()) == 0) {
-              p->killed = 1;
-              break;
-            }
-            memmove(mem, (char*)P2V(pa), PGSIZE);
-            *pte = V2P(mem) | PTE_W | PTE_U | PTE_P;
-            ref_counts[pa/PGSIZE]--;
-            ref_counts[V2P(mem)/PGSIZE] = 1;
-            lcr3(V2P(p->pgdir));
-            break;
-          }
-        }
-
-        // Lazy allocation
-        if((mem = kalloc()) == 0) {
-          p->killed = 1;
-          break;
-        }
-        memset(mem, 0, PGSIZE);
-
-        // For file-backed mapping, read from file
-        if(!(p->mmaps[i].flags & MAP_ANONYMOUS) && p->mmaps[i].ip) {
-            begin_op();
-            ilock(p->mmaps[i].ip);
-            
-            uint offset = aligned_addr - p->mmaps[i].addr;
-            uint size = (offset + PGSIZE > p->mmaps[i].length) ? 
-                        p->mmaps[i].length - offset : PGSIZE;
-            
-            if(readi(p->mmaps[i].ip, mem, offset, size) != size) {
-                iunlock(p->mmaps[i].ip);
-                end_op();
-                kfree(mem);
-                p->killed = 1;
-                break;
-            }
-            
-            if(size < PGSIZE)
-                memset(mem + size, 0, PGSIZE - size);
-            
-            iunlock(p->mmaps[i].ip);
-            end_op();
-        } else {
-            // Handle anonymous mapping
-            // Get content from parent if it exists
-            if(p->parent && p->parent->pgdir) {
-                pte_t *parent_pte = walkpgdir(p->parent->pgdir, (void*)va, 0);
-                if(parent_pte && (*parent_pte & PTE_P)) {
-                    memmove(mem, (char*)P2V(PTE_ADDR(*parent_pte)), PGSIZE);
-                }
-            }
-        }
-
-        if(mappages(p->pgdir, (void*)aligned_addr, PGSIZE, V2P(mem), PTE_W|PTE_U|PTE_P) < 0) {
-            kfree(mem);
-            p->killed = 1;
-        }
-        break;
+  case T_PGFLT:
+    // A bad access from user space kills the process, whatever
+    // the address.
+    if(myproc() && (tf->cs&3) == DPL_USER){
+      if(rcr2() >= KERNBASE || pagefault(rcr2(), tf->err) < 0){
+        cprintf("Segmentation Fault\n");
+        myproc()->killed = 1;
       }
+      break;
     }
-
-    // If address not in any mapping, kill process
-    if(i == NMMAPS) {
-      cprintf("Segmentation Fault\n");
-      p->killed = 1;
-    }
-    break;
-  }
+    // The kernel also faults here when it touches a lazy or
+    // copy-on-write page on behalf of a system call. System calls
+    // fault user buffers in first (uvmprefault), so this only
+    // fails if the kernel has a bug.
+    if(myproc() && rcr2() < KERNBASE && pagefault(rcr2(), tf->err) == 0)
+      break;
+    cprintf("page fault from cpu %d eip %x (cr2=0x%x)\n",
+            cpuid(), tf->eip, rcr2());
+    panic("trap");
 
   case T_IRQ0 + IRQ_TIMER:
     if(cpuid() == 0){
@@ -3,6 +3,8 @@
 
 struct stat;
 struct rtcdate;
+struct kmemstat;
+struct meminfo;
 #include "wmap.h"  
 
 // system calls
@@ -31,6 +33,11 @@ uint wmap(uint addr, int length, int flags, int fd);
 int wunmap(uint addr);
 uint va2pa(uint va);
 int getwmapinfo(struct wmapinfo *wminfo);
+int wmsync(uint addr, int length);
+uint wremap(uint oldaddr, int oldsize, int newsize, int flags);
+int wunmaprange(uint addr, int length);
+int getmeminfo(int slot, struct meminfo *mi);
+int kmemstats(struct kmemstat *st);
 
 // ulib.c
 int stat(const char*, struct stat*);
@@ -5,12 +5,27 @@
 #include "memlayout.h"
 #include "mmu.h"
 #include "proc.h"
+#include "spinlock.h"
 #include "wmap.h"  
 #include "elf.h"
 
 extern char data[];  // defined by kernel.ld
 pde_t *kpgdir;  // for use in scheduler()
 
+// After fork, parent and child share their user page-table pages.
+// A shared page table is mapped without PTE_W and tagged PTE_COW in
+// each page directory that points at it, and its kalloc reference
+// count says how many do. ptlock serializes sharing and unsharing.
+struct spinlock ptlock;
+
+// A read fault on an untouched anonymous wmap page maps this page
+// of zeros read-only and copy-on-write, so the first write copies
+// it like any other COW page. It holds a reference of its own and
+// is never freed.
+static char *zeropage;
+
+#define RA_MAX 16  // Largest file read-ahead window, in pages
+
 // Set up CPU's kernel segment descriptors.
 // Run once on entry on each CPU.
 void
@@ -40,7 +55,12 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
   pte_t *pgtab;
 
   pde = &pgdir[PDX(va)];
+  if(*pde & PTE_PS)
+    return 0;  // A 4MB page, there is no page table
   if(*pde & PTE_P){
+    // The caller is about to add a mapping, so it needs its own copy
+    if(alloc && (*pde & PTE_COW) && ptunshare(pgdir, va) < 0)
+      return 0;
     pgtab = (pte_t*)P2V(PTE_ADDR(*pde));
   } else {
     if(!alloc || (pgtab = (pte_t*)kalloc()) == 0)
@@ -55,6 +75,57 @@ walkpgdir(pde_t *pgdir, const void *va, int alloc)
   return &pgtab[PTX(va)];
 }
 
+// The process whose page table pgdir is, if it is the current one.
+// Changes to it are counted in that process's memory counters.
+static struct proc*
+owner(pde_t *pgdir)
+{
+  struct proc *p = myproc();
+
+  return p && p->pgdir == pgdir ? p : 0;
+}
+
+// Make sure the page table that maps va belongs to pgdir alone,
+// copying it if other page directories still share it. Must be
+// called before changing any PTE that was present at fork.
+// Returns -1 if out of memory.
+int
+ptunshare(pde_t *pgdir, const void *va)
+{
+  pde_t *pde;
+  pte_t *pgtab, *copy;
+  int i;
+
+  pde = &pgdir[PDX(va)];
+  acquire(&ptlock);
+  if((*pde & (PTE_P|PTE_COW)) != (PTE_P|PTE_COW)){
+    release(&ptlock);
+    return 0;
+  }
+  pgtab = (pte_t*)P2V(PTE_ADDR(*pde));
+  if(get_refcount(PTE_ADDR(*pde)) > 1){
+    if((copy = (pte_t*)kalloc()) == 0){
+      release(&ptlock);
+      return -1;
+    }
+    memmove(copy, pgtab, PGSIZE);
+    for(i = 0; i < NPTENTRIES; i++){
+      if(copy[i] & PTE_P)
+        incref(PTE_ADDR(copy[i]));
+      else if(copy[i] & PTE_SWAP)
+        swapdup(copy[i]);
+    }
+    kfree((char*)pgtab);
+    *pde = V2P(copy) | PTE_P | PTE_W | PTE_U;
+  } else {
+    *pde = (*pde & ~PTE_COW) | PTE_W;
+  }
+  release(&ptlock);
+  if(myproc() && pgdir == myproc()->pgdir)
+    lcr3(V2P(pgdir));
+  return 0;
+}
+
 // Create PTEs for virtual addresses starting at va that refer to
 // physical addresses starting at pa. va and size might not
 // be page-aligned.
@@ -141,6 +212,10 @@ setupkvm(void)
 void
 kvmalloc(void)
 {
+  initlock(&ptlock, "ptlock");
+  if((zeropage = kalloc()) == 0)
+    panic("kvmalloc: zero page");
+  memset(zeropage, 0, PGSIZE);
   kpgdir = setupkvm();
   switchkvm();
 }
@@ -222,6 +297,7 @@ loaduvm(pde_t *pgdir, char *addr, struct inode *ip, uint offset, uint sz)
 int
 allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 {
+  struct proc *p = owner(pgdir);
   char *mem;
   uint a;
 
@@ -232,19 +308,20 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 
   a = PGROUNDUP(oldsz);
   for(; a < newsz; a += PGSIZE){
-    mem = kalloc();
+    mem = kzalloc();
     if(mem == 0){
       cprintf("allocuvm out of memory\n");
       deallocuvm(pgdir, newsz, oldsz);
       return 0;
     }
-    memset(mem, 0, PGSIZE);
     if(mappages(pgdir, (char*)a, PGSIZE, V2P(mem), PTE_W|PTE_U) < 0){
       cprintf("allocuvm out of memory (2)\n");
       deallocuvm(pgdir, newsz, oldsz);
       kfree(mem);
       return 0;
     }
+    if(p)
+      p->rss++;
   }
   return newsz;
 }
@@ -256,6 +333,7 @@ allocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 int
 deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 {
+  struct proc *p = owner(pgdir);
   pte_t *pte;
   uint a, pa;
 
@@ -268,11 +346,19 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
     if(!pte)
       a = PGADDR(PDX(a) + 1, 0, 0) - PGSIZE;
     else if((*pte & PTE_P) != 0){
+      if(ptunshare(pgdir, (char*)a) < 0)
+        panic("deallocuvm");
+      pte = walkpgdir(pgdir, (char*)a, 0);
       pa = PTE_ADDR(*pte);
       if(pa == 0)
         panic("kfree");
       char *v = P2V(pa);
       kfree(v);
+      if(p){
+        p->rss--;
+        if(*pte & PTE_COW)
+          p->ncow--;
+      }
       *pte = 0;
     }
   }
@@ -284,16 +370,38 @@ deallocuvm(pde_t *pgdir, uint oldsz, uint newsz)
 void
 freevm(pde_t *pgdir)
 {
-  uint i;
+  uint i, j;
+  pte_t *pgtab;
+  int shared;
 
   if(pgdir == 0)
     panic("freevm: no pgdir");
-  deallocuvm(pgdir, KERNBASE, 0);
   for(i = 0; i < NPDENTRIES; i++){
-    if(pgdir[i] & PTE_P){
-      char * v = P2V(PTE_ADDR(pgdir[i]));
-      kfree(v);
+    if(!(pgdir[i] & PTE_P))
+      continue;
+    if(pgdir[i] & PTE_PS){
+      kfree_order(P2V(pgdir[i] & ~(HUGEPGSIZE-1)), HUGEORDER);
+      continue;
+    }
+    pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[i]));
+    // A page table still shared with another process only loses
+    // this reference; its pages stay with the other owners.
+    acquire(&ptlock);
+    shared = (pgdir[i] & PTE_COW) && get_refcount(PTE_ADDR(pgdir[i])) > 1;
+    if(shared)
+      kfree((char*)pgtab);
+    release(&ptlock);
+    if(shared)
+      continue;
+    if(i < PDX(KERNBASE)){
+      for(j = 0; j < NPTENTRIES; j++){
+        if(pgtab[j] & PTE_P)
+          kfree(P2V(PTE_ADDR(pgtab[j])));
+        else if(pgtab[j] & PTE_SWAP)
+          swapfree(pgtab[j]);
+      }
     }
+    kfree((char*)pgtab);
   }
   kfree((char*)pgdir);
 }
@@ -311,111 +419,563 @@ clearpteu(pde_t *pgdir, char *uva)
   *pte &= ~PTE_U;
 }
 
+// Return 1 if va lies in one of p's MAP_SHARED wmap regions.
+static int
+wmapshared(struct proc *p, uint va)
+{
+  struct vm_area *m = vmafind(p, va);
+
+  return m && (m->flags & MAP_SHARED);
+}
+
 // Given a parent process's page table, create a copy
-// of it for a child.
+// of it for a child. Nothing below KERNBASE is copied: the child
+// shares the parent's page-table pages, and ptunshare copies one
+// when either process changes a PTE in it. Private writable pages
+// become copy-on-write; wmap pages stay shared and writable, and
+// those in swap stay there, shared through their slot (swap.c). A
+// wmap page that maps the zero page is unmapped instead, so that it
+// faults in from the region's anon (anon.c) and the first write by
+// any sharer is seen by all.
 pde_t* copyuvm(pde_t *pgdir, uint sz, struct proc *np)
 {
  pde_t *d;
- pte_t *pte;
- uint pa, i, flags;
- char *mem;
+ pte_t *pgtab;
+ uint i, j;
  struct proc *curproc = myproc();
 
  if((d = setupkvm()) == 0)
    return 0;
+ if(vmacopy(np, curproc) < 0){
+   freevm(d);
+   return 0;
+ }
 
- // Copy normal memory pages
- for(i = 0; i < sz; i += PGSIZE){
-   if((pte = walkpgdir(pgdir, (void *) i, 0)) == 0)
+ acquire(&ptlock);
+ for(i = 0; i < PDX(KERNBASE); i++){
+   if(!(pgdir[i] & PTE_P))
      continue;
-   if(!(*pte & PTE_P))
+   if(pgdir[i] & PTE_PS){
+     // 4MB pages only back MAP_SHARED regions
+     d[i] = pgdir[i];
+     incref(pgdir[i] & ~(HUGEPGSIZE-1));
      continue;
-   pa = PTE_ADDR(*pte);
-   flags = PTE_FLAGS(*pte);
-   if((mem = kalloc()) == 0)
-     goto bad;
-   memmove(mem, (char*)P2V(pa), PGSIZE);
-   if(mappages(d, (void*)i, PGSIZE, V2P(mem), flags) < 0)
-     goto bad;
+   }
+   pgtab = (pte_t*)P2V(PTE_ADDR(pgdir[i]));
+   for(j = 0; j < NPTENTRIES; j++){
+     // Mapping the zero page unshares the page table first, and
+     // regions with an anon never map it, so this table is ours.
+     if((pgtab[j] & PTE_P) && PTE_ADDR(pgtab[j]) == V2P(zeropage)){
+       pgtab[j] = 0;
+       kfree(zeropage);
+       curproc->rss--;
+       curproc->ncow--;
+       curproc->nzero--;
+       continue;
+     }
+     if((pgtab[j] & (PTE_P|PTE_W)) == (PTE_P|PTE_W) &&
+        !wmapshared(curproc, PGADDR(i, j, 0))){
+       pgtab[j] = (pgtab[j] & ~PTE_W) | PTE_COW;
+       curproc->ncow++;
+     }
+   }
+   pgdir[i] = (pgdir[i] & ~PTE_W) | PTE_COW;
+   d[i] = pgdir[i];
+   incref(PTE_ADDR(pgdir[i]));
  }
+ release(&ptlock);
+ np->rss = curproc->rss;
+ np->ncow = curproc->ncow;
+ np->nswap = curproc->nswap;
 
- // Copy memory mappings
-for(i = 0; i < NMMAPS; i++) {
-  if(curproc->mmaps[i].used) {
-    struct vm_area *map = &curproc->mmaps[i];
-    uint addr = map->addr;
-    int length = map->length;
-
-    // Copy mapping metadata
-    np->mmaps[i] = *map;
-    if(map->ip)
-      idup(map->ip);
-
-    // For file-backed mapping, copy pages
-    if(!(map->flags & MAP_ANONYMOUS)) {
-      uint va;
-      for(va = addr; va < addr + length; va += PGSIZE) {
-        pte_t *pte = walkpgdir(pgdir, (void*)va, 0);
-        if(pte && (*pte & PTE_P)) {
-          char *mem = kalloc();
-          if(mem == 0)
-            goto bad;
-          memmove(mem, (char*)P2V(PTE_ADDR(*pte)), PGSIZE);
-          if(mappages(d, (void*)va, PGSIZE, V2P(mem), PTE_FLAGS(*pte)) < 0) {
-            kfree(mem);
-            goto bad;
-          }
-        }
+ // The parent's page tables just became read-only
+ lcr3(V2P(pgdir));
+ return d;
+}
+
+// Give pgdir its own writable copy of the copy-on-write page that
+// pte maps. If nobody else shares the page any more, it is simply
+// made writable again. Returns -1 if out of memory.
+int
+cowcopy(pde_t *pgdir, pte_t *pte)
+{
+  struct proc *p = owner(pgdir);
+  uint pa = PTE_ADDR(*pte);
+  uint flags = (PTE_FLAGS(*pte) & ~PTE_COW) | PTE_W;
+  char *mem;
+
+  if(get_refcount(pa) > 1){
+    if((mem = kalloc()) == 0)
+      return -1;
+    if(pa == V2P(zeropage))
+      memset(mem, 0, PGSIZE);
+    else
+      memmove(mem, (char*)P2V(pa), PGSIZE);
+    *pte = V2P(mem) | flags;
+    kfree((char*)P2V(pa));  // Drop this page table's reference
+  } else {
+    *pte = pa | flags;
+  }
+  if(p){
+    p->ncow--;
+    p->ncowbreak++;
+    if(pa == V2P(zeropage))
+      p->nzero--;
+    lcr3(V2P(pgdir));
+  }
+  return 0;
+}
+
+// Fill in the page at va of file-backed region m. Faults that land
+// where the previous one's window ended are taken as a sequential
+// scan, and each one doubles the number of following pages read in
+// with it, up to RA_MAX; any other fault maps just its own page.
+// Pages come from the page cache, so all processes mapping the file
+// share them, and the inode is locked once per window. Pages read
+// ahead carry PTE_RA so getwmapinfo can count the ones used.
+static int
+filefault(struct proc *p, struct vm_area *m, uint va)
+{
+  uint a, end, off;
+  pte_t *pte;
+  char *mem;
+  int r = 0, major = 0;
+
+  if(va == m->ranext)
+    m->rawin = m->rawin < RA_MAX ? m->rawin * 2 : RA_MAX;
+  else
+    m->rawin = 1;
+  end = va + m->rawin * PGSIZE;
+  if(end > m->addr + m->length)
+    end = m->addr + m->length;
+  m->nfault++;
+
+  begin_op();
+  ilock(m->ip);
+  for(a = va; a < end; a += PGSIZE){
+    if(a != va && (pte = walkpgdir(p->pgdir, (void*)a, 0)) != 0 &&
+       (*pte & PTE_P))
+      break;  // Already loaded
+    off = m->offset + a - m->addr;
+    if(a != va || (mem = pcpeek(m->ip, off)) == 0){
+      if(a == va)
+        major = 1;  // The faulting page itself comes from the file
+      if((mem = pcget(m->ip, off)) == 0)
+        break;
+    }
+    if(mappages(p->pgdir, (void*)a, PGSIZE, V2P(mem),
+                PTE_W|PTE_U|PTE_P|(a != va ? PTE_RA : 0)) < 0){
+      kfree(mem);
+      break;
+    }
+  }
+  iunlock(m->ip);
+  end_op();
+
+  if(a == va)
+    r = -1;  // Could not load the faulting page itself
+  else if(major)
+    p->majflt++;
+  else
+    p->minflt++;
+  p->rss += (a - va) / PGSIZE;
+  m->ranext = a;
+  return r;
+}
+
+// The segment of p's program image that contains va, or 0.
+static struct segment*
+segfind(struct proc *p, uint va)
+{
+  struct segment *s;
+
+  for(s = p->segs; s < p->segs + p->nseg; s++)
+    if(va >= s->va && va < s->va + s->memsz)
+      return s;
+  return 0;
+}
+
+// Fill in the page at va of p's program image, which lies in
+// segment s, or of its heap or a gap between segments if s is 0.
+// A page wholly made of file contents is the page cache's, so every
+// process running the program shares it: read-only for text,
+// copy-on-write for data. A page that bss ends gets a private copy,
+// zeroed past the file part, and a heap page is a zeroed one.
+// Returns -1 if out of memory.
+static int
+execfault(struct proc *p, struct segment *s, uint va)
+{
+  uint off, end, n;
+  char *mem;
+  int perm, major = 0;
+
+  // Set up the page table first, so that mappages cannot fail
+  if(walkpgdir(p->pgdir, (void*)va, 1) == 0)
+    return -1;
+
+  if(s == 0){
+    if((mem = kzalloc()) == 0)
+      return -1;
+    perm = PTE_W|PTE_U;
+  } else {
+    off = s->off + (va - s->va);
+    end = s->va + s->filesz;
+    ilock(p->exe);
+    if(va + PGSIZE <= end || s->filesz == s->memsz){
+      if((mem = pcpeek(p->exe, off)) == 0){
+        major = 1;
+        mem = pcget(p->exe, off);
       }
-    } 
-    // For anonymous shared mapping, share pages
-    else if(map->flags & MAP_SHARED) {
-        uint va;
-        for(va = addr; va < addr + length; va += PGSIZE) {
-            pte_t *pte = walkpgdir(pgdir, (void*)va, 0);
-            char *arr = (char *)addr;
-            if(pte && (*pte & PTE_P)) {
-                // Parent page exists, share it
-                uint pa = PTE_ADDR(*pte);
-                if(mappages(d, (void*)va, PGSIZE, pa, PTE_FLAGS(*pte)) < 0)
-                    goto bad;
-            } else if(arr[va - addr] != 0) {
-                // Page doesn't exist but has been written to
-                char *mem = kalloc();
-                if(mem == 0)
-                    goto bad;
-                memset(mem, arr[va - addr], PGSIZE);
-                if(mappages(d, (void*)va, PGSIZE, V2P(mem), PTE_W|PTE_U|PTE_P) < 0) {
-                    kfree(mem);
-                    goto bad;
-                }
-            }
+      perm = PTE_U | (s->writable ? PTE_COW : 0);
+    } else if((mem = kzalloc()) != 0){
+      if(va < end){
+        major = 1;
+        n = end - va;
+        if(readi(p->exe, mem, off, n) != n){
+          kfree(mem);
+          mem = 0;
         }
+      }
+      perm = PTE_U | (s->writable ? PTE_W : 0);
+    }
+    iunlock(p->exe);
+    if(mem == 0)
+      return -1;
+  }
+
+  mappages(p->pgdir, (void*)va, PGSIZE, V2P(mem), perm);
+  if(perm & PTE_COW)
+    p->ncow++;
+  p->rss++;
+  if(major)
+    p->majflt++;
+  else
+    p->minflt++;
+  return 0;
+}
+
+// Write the dirty pages of the current process's file-backed
+// region m that overlap [start, end) back to the file. Clean pages
+// are skipped, and each run of contiguous dirty pages is copied
+// straight from the mapping in transactions as large as the log
+// allows. Clears PTE_D on the pages once their run is written.
+// Returns -1 if a write fails, leaving that run dirty.
+int
+wmwriteback(struct vm_area *m, uint start, uint end)
+{
+  struct proc *p = myproc();
+  uint max = ((MAXOPBLOCKS-1-1-2) / 2) * 512;  // As in filewrite()
+  uint a, run, off, n;
+  pte_t *pte;
+
+  if(start < m->addr)
+    start = m->addr;
+  end = PGROUNDUP(end);
+  if(end > m->addr + m->length || end < start)
+    end = m->addr + m->length;
+
+  a = PGROUNDDOWN(start);
+  while(a < end){
+    // Find the next run of dirty pages
+    for(run = a; run < end; run += PGSIZE){
+      pte = walkpgdir(p->pgdir, (void*)run, 0);
+      if(pte == 0 || (*pte & (PTE_P|PTE_D)) != (PTE_P|PTE_D))
+        break;
     }
-    // For anonymous private mapping, copy pages
-    else {
-      uint va;
-      for(va = addr; va < addr + length; va += PGSIZE) {
-        pte_t *pte = walkpgdir(pgdir, (void*)va, 0);
-        if(pte && (*pte & PTE_P)) {
-          char *mem = kalloc();
-          if(mem == 0)
-            goto bad;
-          memmove(mem, (char*)P2V(PTE_ADDR(*pte)), PGSIZE);
-          if(mappages(d, (void*)va, PGSIZE, V2P(mem), PTE_FLAGS(*pte)) < 0) {
-            kfree(mem);
-            goto bad;
-          }
+    if(run > end)
+      run = end;
+    p->nwriteback += PGROUNDUP(run - a) / PGSIZE;
+    for(off = a; off < run; off += n){
+      n = run - off < max ? run - off : max;
+      begin_op();
+      ilock(m->ip);
+      if(writei(m->ip, (char*)off, m->offset + off - m->addr, n) != n){
+        iunlock(m->ip);
+        end_op();
+        lcr3(V2P(p->pgdir));
+        return -1;  // The run stays dirty
+      }
+      iunlock(m->ip);
+      end_op();
+    }
+    // Now the run is in the file. A page table still shared since
+    // fork is the other process's too, which has its own writeback
+    // to do, so unshare it before clearing the dirty bits.
+    for(; a < run; a += PGSIZE){
+      if(ptunshare(p->pgdir, (void*)a) < 0){
+        lcr3(V2P(p->pgdir));
+        return -1;
+      }
+      pte = walkpgdir(p->pgdir, (void*)a, 0);
+      *pte &= ~PTE_D;
+    }
+    a += PGSIZE;  // Skip the clean page that ended the run
+  }
+  // The TLB may still hold entries with the dirty bit set
+  lcr3(V2P(p->pgdir));
+  return 0;
+}
+
+// Unmap the pages of the current process's region m that lie in
+// [start, end) and drop their references, writing a shared file
+// mapping back first. start must be page aligned, and no 4MB page
+// may straddle start or end.
+int
+wmfree(struct vm_area *m, uint start, uint end)
+{
+  struct proc *p = myproc();
+  pde_t *pde;
+  pte_t *pte;
+  uint va;
+
+  if(!(m->flags & MAP_ANONYMOUS) && (m->flags & MAP_SHARED) &&
+     wmwriteback(m, start, end) < 0)
+    return -1;
+
+  for(va = start; va < end; va += PGSIZE){
+    pde = &p->pgdir[PDX(va)];
+    if(*pde & PTE_PS){
+      kfree_order(P2V(*pde & ~(HUGEPGSIZE-1)), HUGEORDER);
+      *pde = 0;
+      p->rss -= NPTENTRIES;
+      va += HUGEPGSIZE - PGSIZE;
+      continue;
+    }
+    if((pte = walkpgdir(p->pgdir, (void*)va, 0)) == 0 ||
+       !(*pte & (PTE_P|PTE_SWAP)))
+      continue;
+    // The page table may still be shared with the parent or a child
+    if(ptunshare(p->pgdir, (void*)va) < 0)
+      return -1;
+    pte = walkpgdir(p->pgdir, (void*)va, 0);
+    if(*pte & PTE_SWAP){
+      swapfree(*pte);
+      *pte = 0;
+      p->nswap--;
+    } else {
+      if(*pte & PTE_COW)
+        p->ncow--;
+      if(PTE_ADDR(*pte) == V2P(zeropage))
+        p->nzero--;
+      kfree(P2V(PTE_ADDR(*pte)));
+      *pte = 0;
+      p->rss--;
+    }
+  }
+  lcr3(V2P(p->pgdir));  // Flush stale TLB entries for the range
+  return 0;
+}
+
+// Move the mappings of len bytes at from to the free range at to in
+// pgdir, without copying the pages. from and to must be congruent
+// modulo HUGEPGSIZE if the range holds 4MB pages. Page tables are
+// set up before anything moves, so on failure nothing has.
+int
+wmmove(pde_t *pgdir, uint from, uint to, uint len)
+{
+  uint off;
+  pte_t *src, *dst;
+  int pass;
+
+  for(pass = 0; pass < 2; pass++){
+    for(off = 0; off < len; off += PGSIZE){
+      if(pgdir[PDX(from + off)] & PTE_PS){
+        if(pass == 1){
+          // Any page table left at the destination maps nothing
+          if(pgdir[PDX(to + off)] & PTE_P)
+            kfree(P2V(PTE_ADDR(pgdir[PDX(to + off)])));
+          pgdir[PDX(to + off)] = pgdir[PDX(from + off)];
+          pgdir[PDX(from + off)] = 0;
         }
+        off += HUGEPGSIZE - PGSIZE;
+        continue;
+      }
+      src = walkpgdir(pgdir, (void*)(from + off), 0);
+      if(src == 0 || !(*src & (PTE_P|PTE_SWAP)))
+        continue;
+      if(pass == 0){
+        if(ptunshare(pgdir, (void*)(from + off)) < 0 ||
+           walkpgdir(pgdir, (void*)(to + off), 1) == 0)
+          return -1;
+        continue;
       }
+      dst = walkpgdir(pgdir, (void*)(to + off), 0);
+      *dst = *src;
+      *src = 0;
     }
   }
+  lcr3(V2P(pgdir));
+  return 0;
 }
- return d;
 
-bad:
- freevm(d);
- return 0;
+// Handle a page fault at va in the current process: break
+// copy-on-write sharing, or fill in a page of a wmap region.
+// When memory runs out, reclaim pages and try again.
+// err is the error code pushed by the processor.
+// Returns -1 if the access is not allowed or memory ran out; a
+// user-mode fault then kills the process (see trap), while
+// uvmprefault fails the system call.
+int
+pagefault(uint va, uint err)
+{
+  struct proc *p = myproc();
+  pte_t *pte;
+  struct vm_area *m;
+  struct segment *s;
+  char *mem;
+
+  if(p == 0)
+    panic("pagefault");
+
+  uint aligned_addr = PGROUNDDOWN(va);
+  pde_t *pde = &p->pgdir[PDX(va)];
+  int unshared = 0;
+  if(*pde & PTE_PS)
+    return -1;
+  if((err & FEC_WR) && (*pde & PTE_P) && (*pde & PTE_COW)){
+    if(ptunshare(p->pgdir, (void*)va) < 0)
+      return -1;
+    unshared = 1;
+  }
+  pte = walkpgdir(p->pgdir, (void*)aligned_addr, 0);
+  if(pte && (*pte & PTE_P)){
+    // Present page: only a write to a copy-on-write page is legal
+    if((err & FEC_WR) && (*pte & PTE_COW)){
+      while(cowcopy(p->pgdir, pte) < 0)
+        if(reclaim() == 0)
+          return -1;
+      p->minflt++;
+      return 0;
+    }
+    if((err & FEC_WR) && (*pte & PTE_W) && unshared){
+      p->minflt++;
+      return 0;
+    }
+    return -1;
+  }
+
+  // Read a swapped-out page back in, into a page table of our own
+  if(pte && (*pte & PTE_SWAP)){
+    if(ptunshare(p->pgdir, (void*)va) < 0)
+      return -1;
+    pte = walkpgdir(p->pgdir, (void*)aligned_addr, 0);
+    while(swapin(p, pte) < 0)
+      if(reclaim() == 0)
+        return -1;
+    p->majflt++;
+    return 0;
+  }
+
+  // Page in the program image or heap; a write to text or rodata
+  // is fatal
+  if(va < p->sz){
+    s = segfind(p, va);
+    if(s && (err & FEC_WR) && !s->writable)
+      return -1;
+    while(execfault(p, s, aligned_addr) < 0)
+      if(reclaim() == 0)
+        return -1;
+    return 0;
+  }
+
+  // Not in any mapping
+  if((m = vmafind(p, va)) == 0)
+    return -1;
+
+  // Back a MAP_HUGE chunk that lies wholly inside the region with
+  // a 4MB page, or fall back to 4KB pages if none is free.
+  uint base = va & ~(HUGEPGSIZE-1);
+  if((m->flags & (MAP_HUGE|MAP_ANONYMOUS)) == (MAP_HUGE|MAP_ANONYMOUS) &&
+     m->anon == 0 && base >= m->addr &&
+     base + HUGEPGSIZE <= m->addr + m->length &&
+     !(*pde & PTE_P) && (mem = kalloc_order(HUGEORDER)) != 0){
+    memset(mem, 0, HUGEPGSIZE);
+    *pde = V2P(mem) | PTE_PS | PTE_P | PTE_W | PTE_U;
+    m->nhuge++;
+    p->rss += NPTENTRIES;
+    p->minflt++;
+    return 0;
+  }
+
+  // For file-backed mapping, read from file
+  if(!(m->flags & MAP_ANONYMOUS) && m->ip){
+    while(filefault(p, m, aligned_addr) < 0)
+      if(reclaim() == 0)
+        return -1;
+    return 0;
+  }
+
+  // In a region shared by fork, take the page every sharer maps
+  if(m->anon){
+    uint off = m->offset + (aligned_addr - m->addr);
+    while(walkpgdir(p->pgdir, (void*)aligned_addr, 1) == 0 ||
+          (mem = anonget(m->anon, off)) == 0)
+      if(reclaim() == 0)
+        return -1;
+    mappages(p->pgdir, (void*)aligned_addr, PGSIZE, V2P(mem),
+             PTE_W|PTE_U|PTE_P);
+    p->rss++;
+    p->minflt++;
+    return 0;
+  }
+
+  // A read maps the zero page
+  if(!(err & FEC_WR)){
+    while(walkpgdir(p->pgdir, (void*)aligned_addr, 1) == 0)
+      if(reclaim() == 0)
+        return -1;
+    incref(V2P(zeropage));
+    mappages(p->pgdir, (void*)aligned_addr, PGSIZE, V2P(zeropage),
+             PTE_U|PTE_COW);
+    p->rss++;
+    p->ncow++;
+    p->nzero++;
+    p->minflt++;
+    return 0;
+  }
+
+  // Lazy allocation. Set up the page table too, so that mappages
+  // below cannot run out of memory.
+  while((mem = kzalloc()) == 0 ||
+        walkpgdir(p->pgdir, (void*)aligned_addr, 1) == 0){
+    if(mem)
+      kfree(mem);
+    if(reclaim() == 0)
+      return -1;
+  }
+
+  if(mappages(p->pgdir, (void*)aligned_addr, PGSIZE, V2P(mem), PTE_W|PTE_U|PTE_P) < 0) {
+      kfree(mem);
+      return -1;
+  }
+  p->rss++;
+  p->minflt++;
+  return 0;
+}
+
+// Fault in the pages of the current process's buffer [va, va+n),
+// with write access if write is set. System calls do this before
+// code that copies to or from the buffer while holding a lock, which
+// a fault that reads the page from disk could not do. Returns -1 if
+// the process may not access the buffer that way.
+int
+uvmprefault(uint va, uint n, int write)
+{
+  struct proc *p = myproc();
+  pte_t *pte;
+  uint a;
+
+  for(a = PGROUNDDOWN(va); a < va + n; a += PGSIZE){
+    if(p->pgdir[PDX(a)] & PTE_PS)
+      continue;
+    pte = walkpgdir(p->pgdir, (void*)a, 0);
+    if(pte && (*pte & PTE_P) &&
+       (!write || ((*pte & PTE_W) && (p->pgdir[PDX(a)] & PTE_W))))
+      continue;
+    if(pagefault(a, write ? FEC_WR : 0) < 0)
+      return -1;
+  }
+  return 0;
 }
 
 //PAGEBREAK!
@@ -441,10 +1001,18 @@ copyout(pde_t *pgdir, uint va, void *p, uint len)
 {
   char *buf, *pa0;
   uint n, va0;
+  pte_t *pte;
 
   buf = (char*)p;
   while(len > 0){
     va0 = (uint)PGROUNDDOWN(va);
+    // The kernel writes through its own mapping of the page, which
+    // the PTE_W bit does not protect, so break COW sharing first.
+    if(ptunshare(pgdir, (char*)va0) < 0)
+      return -1;
+    pte = walkpgdir(pgdir, (char*)va0, 0);
+    if(pte && (*pte & PTE_COW) && cowcopy(pgdir, pte) < 0)
+      return -1;
     pa0 = uva2ka(pgdir, (char*)va0);
     if(pa0 == 0)
       return -1;
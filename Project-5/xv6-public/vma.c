@@ -0,0 +1,286 @@
+// Per-process table of wmap regions.
+//
+// p->mmaps is an array of p->total_mmaps vm_areas sorted by address,
+// so a fault finds its region by binary search. The array lives in
+// a kalloc_order() block of order p->mmaporder that doubles when it
+// fills, up to NMMAPS regions. Pointers into it are only good until
+// the next vmainsert or vmaremove.
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "wmap.h"
+
+#define VMACAP(order) ((PGSIZE << (order)) / sizeof(struct vm_area))
+
+// Index of the first region of p that ends after va.
+static int
+vmaindex(struct proc *p, uint va)
+{
+  int lo = 0, hi = p->total_mmaps, mid;
+
+  while(lo < hi){
+    mid = (lo + hi) / 2;
+    if(p->mmaps[mid].addr + p->mmaps[mid].length <= va)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+// Return the region of p that contains va, or 0.
+struct vm_area*
+vmafind(struct proc *p, uint va)
+{
+  int i = vmaindex(p, va);
+
+  if(i < p->total_mmaps && p->mmaps[i].addr <= va)
+    return &p->mmaps[i];
+  return 0;
+}
+
+// Return the first region of p that overlaps [addr, addr+length),
+// or 0 if the range is free. Later overlapping regions follow it
+// in the array.
+struct vm_area*
+vmaoverlap(struct proc *p, uint addr, uint length)
+{
+  int i = vmaindex(p, addr);
+
+  if(i < p->total_mmaps && p->mmaps[i].addr < addr + length)
+    return &p->mmaps[i];
+  return 0;
+}
+
+// Make room in p->mmaps for one more region.
+static int
+vmagrow(struct proc *p)
+{
+  struct vm_area *a;
+  int order;
+
+  if(p->mmaps && p->total_mmaps < VMACAP(p->mmaporder))
+    return 0;
+  if(p->total_mmaps >= NMMAPS)
+    return -1;
+  order = p->mmaps ? p->mmaporder + 1 : 0;
+  if((a = (struct vm_area*)kalloc_order(order)) == 0)
+    return -1;
+  if(p->mmaps){
+    memmove(a, p->mmaps, p->total_mmaps * sizeof(struct vm_area));
+    kfree_order((char*)p->mmaps, p->mmaporder);
+  }
+  p->mmaps = a;
+  p->mmaporder = order;
+  return 0;
+}
+
+// Add a zeroed region [addr, addr+length) to p. Returns 0 if it
+// overlaps an existing region or p has no room for it.
+struct vm_area*
+vmainsert(struct proc *p, uint addr, uint length)
+{
+  struct vm_area *m;
+  int i;
+
+  if(length == 0 || addr + length < addr || vmaoverlap(p, addr, length))
+    return 0;
+  if(vmagrow(p) < 0)
+    return 0;
+  i = vmaindex(p, addr);
+  m = &p->mmaps[i];
+  memmove(m + 1, m, (p->total_mmaps - i) * sizeof(*m));
+  memset(m, 0, sizeof(*m));
+  m->addr = addr;
+  m->length = length;
+  p->total_mmaps++;
+  return m;
+}
+
+// Find a free range of length bytes for p between MMAPBASE and
+// KERNBASE, starting at a multiple of align. With bestfit, take the
+// gap with the least room left after aligning, else the lowest one.
+// Returns 0 if no gap is big enough.
+uint
+vmaplace(struct proc *p, uint length, uint align, int bestfit)
+{
+  uint start, end, a, best, bestsize;
+  int i;
+
+  best = 0;
+  bestsize = 0;
+  start = MMAPBASE;
+  for(i = 0; i <= p->total_mmaps; i++){
+    end = i < p->total_mmaps ? p->mmaps[i].addr : KERNBASE;
+    a = (start + align - 1) & ~(align - 1);
+    if(a >= start && a < end && end - a >= length){
+      if(!bestfit)
+        return a;
+      if(best == 0 || end - a < bestsize){
+        best = a;
+        bestsize = end - a;
+      }
+    }
+    if(i < p->total_mmaps)
+      start = PGROUNDUP(p->mmaps[i].addr + p->mmaps[i].length);
+  }
+  return best;
+}
+
+// Remove region m from p's table.
+void
+vmaremove(struct proc *p, struct vm_area *m)
+{
+  int i = m - p->mmaps;
+
+  memmove(m, m + 1, (p->total_mmaps - i - 1) * sizeof(*m));
+  p->total_mmaps--;
+}
+
+// Split the region of p that contains va in two at va, unless va
+// is its start. The file and anon references, offset and id carry
+// over to the upper half. Returns -1 if p has no room for another region.
+static int
+vmasplit(struct proc *p, uint va)
+{
+  struct vm_area *m, *n;
+  uint len;
+
+  if((m = vmafind(p, va)) == 0 || m->addr == va)
+    return 0;
+  len = m->addr + m->length - va;
+  m->length = va - m->addr;
+  if((n = vmainsert(p, va, len)) == 0){
+    m->length += len;
+    return -1;
+  }
+  m = n - 1;  // The table may have moved
+  n->flags = m->flags;
+  n->id = m->id;
+  n->offset = m->offset + (va - m->addr);
+  if(m->ip)
+    n->ip = idup(m->ip);
+  if(m->anon)
+    n->anon = anondup(m->anon);
+  return 0;
+}
+
+// Unmap [start, end) from p, trimming or splitting the regions it
+// cuts through. start must be page aligned. Fails without unmapping
+// anything if no region overlaps the range, a 4MB page straddles
+// either end, or p has no room for the pieces.
+int
+vmaunmap(struct proc *p, uint start, uint end)
+{
+  struct vm_area *m;
+
+  end = PGROUNDUP(end);
+  if(end <= start || vmaoverlap(p, start, end - start) == 0)
+    return -1;
+  if((start % HUGEPGSIZE && (p->pgdir[PDX(start)] & PTE_PS)) ||
+     (end % HUGEPGSIZE && (p->pgdir[PDX(end)] & PTE_PS)))
+    return -1;
+  if(vmasplit(p, start) < 0 || vmasplit(p, end) < 0)
+    return -1;
+
+  while((m = vmaoverlap(p, start, end - start)) != 0){
+    if(wmfree(m, m->addr, m->addr + m->length) < 0)
+      return -1;
+    if(m->ip){
+      begin_op();
+      iput(m->ip);
+      end_op();
+    }
+    if(m->anon)
+      anonput(m->anon);
+    vmaremove(p, m);
+  }
+  return 0;
+}
+
+// Join region m with the regions right after it that continue it:
+// pieces of the same wmap, so same flags and file, whose file
+// offsets line up. Separate wmaps stay apart even when they touch,
+// so each can still be wunmapped on its own.
+void
+vmamerge(struct proc *p, struct vm_area *m)
+{
+  struct vm_area *n;
+
+  for(n = m + 1; n < p->mmaps + p->total_mmaps; ){
+    if(PGROUNDUP(m->addr + m->length) != n->addr || m->id != n->id ||
+       m->flags != n->flags || m->ip != n->ip || m->anon != n->anon ||
+       (m->ip && n->offset != m->offset + (n->addr - m->addr)))
+      break;
+    m->length = n->addr + n->length - m->addr;
+    m->nhuge += n->nhuge;
+    m->nfault += n->nfault;
+    if(n->ip){
+      begin_op();
+      iput(n->ip);  // m still holds a reference
+      end_op();
+    }
+    if(n->anon)
+      anonput(n->anon);
+    vmaremove(p, n);
+  }
+}
+
+// Give np a copy of p's regions, taking a reference on each file.
+// Anonymous regions of p get an anon to share with np first.
+int
+vmacopy(struct proc *np, struct proc *p)
+{
+  struct vm_area *m;
+  int i;
+
+  np->mmaps = 0;
+  np->total_mmaps = 0;
+  np->nextmapid = p->nextmapid;
+  if(p->mmaps == 0)
+    return 0;
+  for(m = p->mmaps; m < p->mmaps + p->total_mmaps; m++)
+    if((m->flags & MAP_ANONYMOUS) && m->anon == 0 &&
+       (m->anon = anonalloc()) == 0)
+      return -1;
+  if((np->mmaps = (struct vm_area*)kalloc_order(p->mmaporder)) == 0)
+    return -1;
+  np->mmaporder = p->mmaporder;
+  np->total_mmaps = p->total_mmaps;
+  memmove(np->mmaps, p->mmaps, p->total_mmaps * sizeof(struct vm_area));
+  for(i = 0; i < np->total_mmaps; i++){
+    if(np->mmaps[i].ip)
+      idup(np->mmaps[i].ip);
+    if(np->mmaps[i].anon)
+      anondup(np->mmaps[i].anon);
+  }
+  return 0;
+}
+
+// Release the current process's regions on exit, writing shared
+// file mappings back first. The pages go with the page table.
+void
+vmafree(struct proc *p)
+{
+  struct vm_area *m;
+
+  for(m = p->mmaps; m < p->mmaps + p->total_mmaps; m++){
+    if(m->anon)
+      anonput(m->anon);
+    if(m->ip == 0)
+      continue;
+    if(m->flags & MAP_SHARED)
+      wmwriteback(m, m->addr, m->addr + m->length);
+    begin_op();
+    iput(m->ip);
+    end_op();
+  }
+  if(p->mmaps)
+    kfree_order((char*)p->mmaps, p->mmaporder);
+  p->mmaps = 0;
+  p->total_mmaps = 0;
+}
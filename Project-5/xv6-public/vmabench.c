@@ -0,0 +1,57 @@
+// Mapping lookup benchmark. Keeps a growing number of idle wmap
+// regions in place and times a probe region that is mapped, faulted
+// in and unmapped over and over, so every round does an insert, a
+// fault lookup and a removal among that many regions.
+//
+// usage: vmabench [rounds]
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define PGSIZE 4096
+#define MAPBASE 0x60000000
+#define PROBE (MAPBASE + 0x10000000)
+
+int counts[] = {1, 16, 64, 256, 500};
+
+int
+main(int argc, char *argv[])
+{
+  int i, k, n, mapped, rounds, start, t;
+  int flags = MAP_FIXED | MAP_SHARED | MAP_ANONYMOUS;
+  char *p;
+
+  rounds = argc > 1 ? atoi(argv[1]) : 2000;
+  if(rounds < 1){
+    printf(2, "usage: vmabench [rounds]\n");
+    exit();
+  }
+
+  mapped = 0;
+  for(k = 0; k < sizeof(counts) / sizeof(counts[0]); k++){
+    // Idle regions sit every other page below the probe
+    n = counts[k];
+    for(; mapped < n; mapped++){
+      if(wmap(MAPBASE + mapped * 2 * PGSIZE, PGSIZE, flags, -1) == FAILED){
+        printf(2, "vmabench: wmap of region %d failed\n", mapped);
+        exit();
+      }
+    }
+
+    start = uptime();
+    for(i = 0; i < rounds; i++){
+      p = (char*)wmap(PROBE, PGSIZE, flags, -1);
+      if(p == (char*)FAILED){
+        printf(2, "vmabench: probe wmap failed\n");
+        exit();
+      }
+      p[0] = i;
+      wunmap(PROBE);
+    }
+    t = uptime() - start;
+    printf(1, "vmabench: %d regions, %d map+fault+unmap rounds in %d ticks\n",
+           n, rounds, t);
+  }
+  exit();
+}
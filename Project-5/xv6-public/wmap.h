@@ -5,6 +5,12 @@
 #define MAP_SHARED 0x0002
 #define MAP_ANONYMOUS 0x0004
 #define MAP_FIXED 0x0008
+#define MAP_HUGE 0x0010       // Back 4MB-aligned anonymous chunks with 4MB pages
+#define MAP_FIRSTFIT 0x0020   // Without MAP_FIXED: kernel picks the lowest free gap
+#define MAP_BESTFIT 0x0040    // Without MAP_FIXED: kernel picks the smallest free gap
+
+// Flags for wremap
+#define MREMAP_MAYMOVE 0x1
 
 // When any system call fails, returns -1
 #define FAILED -1
@@ -17,5 +23,8 @@ struct wmapinfo {
     int addr[MAX_WMMAP_INFO];           // Starting address of mapping
     int length[MAX_WMMAP_INFO];         // Size of mapping
     int n_loaded_pages[MAX_WMMAP_INFO]; // Number of pages physically loaded into memory
+    int n_huge_pages[MAX_WMMAP_INFO];   // Number of 4MB pages among them
+    int n_faults[MAX_WMMAP_INFO];       // Page faults taken in the mapping
+    int n_faults_saved[MAX_WMMAP_INFO]; // Pages read ahead and since accessed
 };
 #endif // _WMAP_H_
\ No newline at end of file
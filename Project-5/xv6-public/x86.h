@@ -144,6 +144,16 @@ lcr3(uint val)
   asm volatile("movl %0,%%cr3" : : "r" (val));
 }
 
+// Low 32 bits of the time-stamp counter; enough to time short
+// operations by taking the difference of two readings.
+static inline uint
+rdtsc(void)
+{
+  uint lo;
+  asm volatile("rdtsc" : "=a" (lo) : : "edx");
+  return lo;
+}
+
 //PAGEBREAK: 36
 // Layout of the trap frame built on the stack by the
 // hardware and by trapasm.S, and passed to trap().